@@ -0,0 +1,130 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Arena.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace json {
+
+namespace
+{
+	const std::size_t max_block_size = 1024 * 1024;
+
+	char* AlignUp(char *p, std::size_t align)
+	{
+		auto addr = reinterpret_cast<std::uintptr_t>(p);
+		return p + ((align - addr % align) % align);
+	}
+}
+
+Arena::Arena(std::size_t block_size) :
+	m_blocks(nullptr),
+	m_pos(nullptr),
+	m_end(nullptr),
+	m_block_size(std::max<std::size_t>(block_size, 64)),
+	m_size(0)
+{
+}
+
+Arena::~Arena()
+{
+	Release();
+}
+
+/**	Allocates memory from the current block, or a new block if it is full.
+
+	Blocks grow by doubling up to 1MB. Allocations larger than that get a
+	block of their own.
+*/
+void* Arena::Allocate(std::size_t size, std::size_t align)
+{
+	assert(align > 0 && (align & (align-1)) == 0);
+	
+	char *p = m_pos ? AlignUp(m_pos, align) : nullptr;
+	if (p == nullptr || size > static_cast<std::size_t>(m_end - p))
+		return AllocateBlock(size, align);
+	
+	m_pos   = p + size;
+	m_size += size;
+	return p;
+}
+
+void* Arena::AllocateBlock(std::size_t size, std::size_t align)
+{
+	std::size_t header = sizeof(Block) + alignof(std::max_align_t);
+	std::size_t needed = size + align + header;
+	
+	bool dedicated = needed > m_block_size;
+	std::size_t block_size = dedicated ? needed : m_block_size;
+	
+	Block *block = static_cast<Block*>(::operator new(block_size));
+	block->size  = block_size;
+	
+	char *begin = reinterpret_cast<char*>(block) + sizeof(Block);
+	char *p     = AlignUp(begin, align);
+	
+	// a dedicated block is put behind the current one, which is not full yet
+	if (dedicated && m_blocks)
+	{
+		block->next      = m_blocks->next;
+		m_blocks->next   = block;
+	}
+	else
+	{
+		block->next = m_blocks;
+		m_blocks    = block;
+		m_pos       = p + size;
+		m_end       = reinterpret_cast<char*>(block) + block_size;
+		
+		m_block_size = std::min(m_block_size * 2, max_block_size);
+	}
+	
+	m_size += size;
+	return p;
+}
+
+/**	Frees all memory allocated from the Arena.
+
+	It takes one deallocation per block, regardless of the number of objects
+	allocated.
+*/
+void Arena::Release()
+{
+	while (m_blocks)
+	{
+		Block *next = m_blocks->next;
+		::operator delete(m_blocks);
+		m_blocks = next;
+	}
+	m_pos  = nullptr;
+	m_end  = nullptr;
+	m_size = 0;
+}
+
+/// Total number of bytes allocated.
+std::size_t Arena::Size() const
+{
+	return m_size;
+}
+
+} // end of namespace
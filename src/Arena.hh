@@ -0,0 +1,141 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef ARENA_HH_INCLUDED
+#define ARENA_HH_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace json {
+
+/**	A monotonic allocator that releases all its memory at once.
+
+	Memory is handed out from large blocks by bumping a pointer. Individual
+	allocations are never freed: the blocks are released together by Release()
+	or the destructor. Objects allocated from an Arena are not destroyed by it,
+	so they must not own memory outside of the Arena.
+	
+	An Arena is not thread-safe.
+*/
+class Arena
+{
+public:
+	explicit Arena(std::size_t block_size = 4096);
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	~Arena();
+	
+	void* Allocate(std::size_t size, std::size_t align = alignof(std::max_align_t));
+	void Release();
+	
+	std::size_t Size() const;
+	
+private:
+	struct Block
+	{
+		Block		*next;
+		std::size_t	size;
+	};
+	
+	void* AllocateBlock(std::size_t size, std::size_t align);
+	
+private:
+	Block		*m_blocks;
+	char		*m_pos;
+	char		*m_end;
+	std::size_t	m_block_size;
+	std::size_t	m_size;
+};
+
+/**	A standard allocator that allocates from an Arena.
+
+	If no Arena is given, it allocates from the heap like std::allocator. Copies
+	of containers using ArenaAllocator are allocated from the heap, so that they
+	can outlive the Arena.
+*/
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+	
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap            = std::true_type;
+	
+	template <typename U>
+	struct rebind
+	{
+		using other = ArenaAllocator<U>;
+	};
+	
+public:
+	ArenaAllocator(Arena *arena = nullptr) noexcept : m_arena(arena)
+	{
+	}
+	
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.GetArena())
+	{
+	}
+	
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(m_arena ?
+			m_arena->Allocate(n * sizeof(T), alignof(T)) :
+			::operator new(n * sizeof(T)));
+	}
+	
+	void deallocate(T *p, std::size_t) noexcept
+	{
+		if (!m_arena)
+			::operator delete(p);
+	}
+	
+	ArenaAllocator select_on_container_copy_construction() const
+	{
+		return ArenaAllocator();
+	}
+	
+	Arena* GetArena() const
+	{
+		return m_arena;
+	}
+	
+private:
+	Arena	*m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a1, const ArenaAllocator<U>& a2)
+{
+	return a1.GetArena() == a2.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a1, const ArenaAllocator<U>& a2)
+{
+	return a1.GetArena() != a2.GetArena();
+}
+
+} // end of namespace
+
+#endif
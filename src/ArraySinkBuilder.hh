@@ -0,0 +1,188 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef ARRAYSINKBUILDER_HH_INCLUDED
+#define ARRAYSINKBUILDER_HH_INCLUDED
+
+#include "TypeBuilder.hh"
+
+#include <cassert>
+#include <functional>
+#include <memory>
+
+namespace json {
+
+template <typename Host> class JsonBuilder;
+
+/**	The target of ArraySinkBuilder.
+
+	Instead of a container, the sink holds a single element and a callback.
+	Each element of the JSON array is built into the same element, which is then
+	passed to the callback as soon as the element ends. The element is reset to
+	a default constructed T before each element is built, keeping the capacity
+	of its strings, so members missing in an element do not keep the values of
+	the previous one.
+*/
+template <typename T>
+struct ArraySink
+{
+	using Callback = std::function<void(T&)>;
+	
+	ArraySink() = default;
+	explicit ArraySink(const Callback& cb) : callback(cb) {}
+	
+	T			element{};
+	Callback	callback;
+};
+
+/**	Builds the elements of a JSON array one at a time and hands them to a callback.
+
+	ArraySinkBuilder is used in place of VectorBuilder when the array is too large
+	to be kept in memory. The elements are delivered while the document is still
+	being parsed, and they share the same storage, so arrays of any size are
+	processed in constant memory.
+	
+	\code{.cpp}
+	struct Response
+	{
+		std::string			next;
+		ArraySink<Record>	records;
+	};
+	JsonBuilder<Response> h =
+	{
+		{"next",    &Response::next},
+		{"records", &Response::records, ArraySinkBuilder<Record>(record_builder)}
+	};
+	Response r;
+	r.records.callback = [](Record& rec) { ... };
+	\endcode
+*/
+template <typename T>
+class ArraySinkBuilder : public TypeBuilder<ArraySink<T>>
+{
+public:
+	using HostType = ArraySink<T>;
+	
+public:
+	ArraySinkBuilder(const ArraySinkBuilder&) = default;
+#ifndef _MSC_VER
+	ArraySinkBuilder(ArraySinkBuilder&&) = default;
+#endif
+	~ArraySinkBuilder() override = default;
+	
+	template <typename Builder=JsonBuilder<T>>
+	ArraySinkBuilder(const Builder& v) :
+		m_visitor(std::make_shared<Builder>(v)),
+		m_elem(std::make_shared<ElementBuilder>(m_visitor))
+	{
+		static_assert(
+			std::is_base_of<TypeBuilder<T>, Builder>::value,
+			"member type and visitor does not match");
+	}
+
+	// strings, numbers and literals are complete elements
+	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override
+	{
+		assert(this->Check(current));
+		
+		auto sink = current.Target<HostType>();
+		detail::Reset(sink->element);
+		m_visitor->Data(Cursor{current.Key(), &sink->element, m_visitor.get()}, type, data, len);
+		Deliver(sink);
+	}
+	
+	// objects and arrays are complete when ElementBuilder finishes them
+	Cursor Advance(const Cursor& current) const override
+	{
+		assert(this->Check(current));
+		return current.Forward(m_elem.get());
+	}
+
+	void Finish(const Cursor& current) const override
+	{
+		assert(this->Check(current));
+	}
+
+private:
+	static void Deliver(HostType *sink)
+	{
+		if (sink->callback)
+			sink->callback(sink->element);
+	}
+	
+	/**	Builds an object or array element with the element builder, and
+		delivers it at the end.
+		
+		The target of its Cursor is the sink, so it can find the callback.
+	*/
+	class ElementBuilder : public TypeBuilder<HostType>
+	{
+	public:
+		explicit ElementBuilder(const std::shared_ptr<const JsonProcessor>& visitor) :
+			m_visitor(visitor)
+		{
+		}
+		
+		void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override
+		{
+			assert(this->Check(current));
+			m_visitor->Data(Element(current), type, data, len);
+		}
+		
+		Cursor Advance(const Cursor& current) const override
+		{
+			assert(this->Check(current));
+			return m_visitor->Advance(Element(current));
+		}
+		
+		void Start(const Cursor& current, JSON_event type) const override
+		{
+			assert(this->Check(current));
+			detail::Reset(current.Target<HostType>()->element);
+			m_visitor->Start(Element(current), type);
+		}
+		
+		void Finish(const Cursor& current) const override
+		{
+			assert(this->Check(current));
+			m_visitor->Finish(Element(current));
+			Deliver(current.Target<HostType>());
+		}
+		
+	private:
+		Cursor Element(const Cursor& current) const
+		{
+			Cursor elem = current.Forward(m_visitor.get());
+			elem.SetTarget(&current.Target<HostType>()->element);
+			return elem;
+		}
+		
+	private:
+		std::shared_ptr<const JsonProcessor>	m_visitor;
+	};
+
+private:
+	std::shared_ptr<const JsonProcessor>	m_visitor;
+	std::shared_ptr<const ElementBuilder>	m_elem;
+};
+
+} // end of namespace
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "EmitData.hh"
 #include "Exception.hh"
+#include "MappedFile.hh"
 #include "Range.hh"
 
 #include <vector>
@@ -664,6 +665,18 @@ void Automaton::Parse(const char *str, std::size_t len)
 	m_impl->Parse(str, len);
 }
 
+/**	Parses the whole content of a file.
+
+	The file is memory-mapped and given to Parse() in one call. The strings
+	given to the callback refer to the mapping, which is unmapped when this
+	function returns.
+*/
+void Automaton::ParseFile(const std::string& path)
+{
+	MappedFile file(path);
+	Parse(file.Data(), file.Size());
+}
+
 bool Automaton::Result() const
 {
 	return m_impl->Result();
@@ -64,6 +64,7 @@ public :
 	~Automaton();
 	
 	void Parse(const char *str, std::size_t len);
+	void ParseFile(const std::string& path);
 	bool Result() const;
 	
 private :
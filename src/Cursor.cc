@@ -22,12 +22,19 @@
 #include "JsonProcessor.hh"
 #include "TypeBuilder.hh"
 
+#include <type_traits>
+
 namespace json {
 
+static_assert(std::is_trivially_copyable<Cursor>::value, "Cursor should be trivially copyable");
+
 Cursor::Cursor(const JsonProcessor *rec) :
 	m_obj(nullptr),
 	m_rec(rec),
-	m_type(typeid(void))
+	m_predict(nullptr)
+#if AUTOJSON_CHECKED_CURSOR
+	, m_type(typeid(void))
+#endif
 {
 }
 	
@@ -35,7 +42,10 @@ Cursor::Cursor(const ::json::Key& key) :
 	m_key(key),
 	m_obj(nullptr),
 	m_rec(MockObjectHandler::Instance()),
-	m_type(typeid(void))
+	m_predict(nullptr)
+#if AUTOJSON_CHECKED_CURSOR
+	, m_type(typeid(void))
+#endif
 {
 }
 	
@@ -49,6 +59,16 @@ const JsonProcessor* Cursor::Rec() const
 	return m_rec;
 }
 
+void Cursor::SetPredictor(KeyPredictor *predict)
+{
+	m_predict = predict;
+}
+
+KeyPredictor* Cursor::Predictor() const
+{
+	return m_predict;
+}
+
 void Cursor::SetKey(const ::json::Key& key)
 {
 	m_key = key;
@@ -63,7 +83,10 @@ Cursor Cursor::Forward(const JsonProcessor *rec) const
 
 Cursor::operator bool() const
 {
-	return m_obj != nullptr && m_type != typeid(void);
+#if AUTOJSON_CHECKED_CURSOR
+	assert(m_obj == nullptr || m_type != typeid(void));
+#endif
+	return m_obj != nullptr;
 }
 
 } // end of namespace
@@ -28,9 +28,25 @@
 #include <typeindex>
 #include <iostream>
 
+/**	Enables checking the type of the targets of Cursors at run time.
+
+	It is enabled in debug builds by default. The builders already make sure
+	the types match at compile time, so release builds skip the check and the
+	Cursor does not need to store the type. The library and its users must
+	be compiled with the same setting.
+*/
+#ifndef AUTOJSON_CHECKED_CURSOR
+	#ifdef NDEBUG
+		#define AUTOJSON_CHECKED_CURSOR 0
+	#else
+		#define AUTOJSON_CHECKED_CURSOR 1
+	#endif
+#endif
+
 namespace json {
 
 class JsonProcessor;
+class KeyPredictor;
 
 /**	A Cursor is an object that points to a specific location within a hash or array, as
 	well as a pointer to the current C++ object being built.
@@ -40,7 +56,11 @@ class JsonProcessor;
 	- A pointer to the C++ object being built. It's called Target().
 	- The JsonVisitor that is suppose to build the host.
 	
-	The target (i.e. object being built) is not owned by the Cursor.
+	The target (i.e. object being built) is not owned by the Cursor. Neither is
+	the key, so Cursors are trivially copyable.
+	
+	The JsonParser also attaches a KeyPredictor to the Cursors of the objects
+	it is parsing. Builders may use it to speed up looking up the keys.
 */
 class Cursor
 {
@@ -50,7 +70,10 @@ public :
 		m_key(key),
 		m_obj(target),
 		m_rec(rec),
-		m_type(typeid(TargetType))
+		m_predict(nullptr)
+#if AUTOJSON_CHECKED_CURSOR
+		, m_type(typeid(TargetType))
+#endif
 	{
 		assert(m_obj);
 	}
@@ -63,6 +86,9 @@ public :
 	void SetKey(const ::json::Key& key);
 	const ::json::Key& Key() const;
 	const JsonProcessor* Rec() const;
+	
+	void SetPredictor(KeyPredictor *predict);
+	KeyPredictor* Predictor() const;
 
 	Cursor Forward(const JsonProcessor *rec) const;
 	
@@ -70,7 +96,9 @@ public :
 	void SetTarget(TargetType *target)
 	{
 		m_obj  = target;
+#if AUTOJSON_CHECKED_CURSOR
 		m_type = typeid(TargetType);
+#endif
 	}
 	
 	/**	Returns a pointer to the objects being built.
@@ -78,6 +106,7 @@ public :
 		Note that the Cursor does not own this object. Also, the caller needs to
 		specify the type of the object as the template parameter. If the type
 		is different from the actual type, this function will throw TypeMismatch.
+		The type is only checked when AUTOJSON_CHECKED_CURSOR is enabled.
 		
 		\throw	TypeMismatch	If the target type is different from the type
 								specified in the template parameter.
@@ -85,12 +114,13 @@ public :
 	template <typename TargetType>
 	TargetType* Target() const
 	{
-		if (m_type == typeid(TargetType))
-			return static_cast<TargetType*>(m_obj);
-	
-		throw TypeMismatch()
-			<< ExpectedTypeInfo(typeid(TargetType))
-			<< ActualTypeInfo(m_type);
+#if AUTOJSON_CHECKED_CURSOR
+		if (m_type != typeid(TargetType))
+			throw TypeMismatch()
+				<< ExpectedTypeInfo(typeid(TargetType))
+				<< ActualTypeInfo(m_type);
+#endif
+		return static_cast<TargetType*>(m_obj);
 	}
 	
 	explicit operator bool() const;
@@ -99,7 +129,10 @@ private :
 	::json::Key			m_key;
 	void				*m_obj;	//!< The object being built by JSON
 	const JsonProcessor	*m_rec;	//!< The Reactor that builds the members of the object
+	KeyPredictor		*m_predict;	//!< Not owned. Only set by JsonParser
+#if AUTOJSON_CHECKED_CURSOR
 	std::type_index		m_type;
+#endif
 };
 
 } // end of namespace
@@ -0,0 +1,325 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Decompressor.hh"
+#include "Exception.hh"
+#include "ReadAhead.hh"
+
+#ifdef AUTOJSON_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef AUTOJSON_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstring>
+
+namespace json {
+
+namespace detail
+{
+	/**	Decompresses one chunk of input in a specific format.
+	*/
+	class Codec
+	{
+	public:
+		virtual ~Codec() = default;
+
+		/**	Decompresses as much input to the output as possible, and advances
+			\a in and \a out to where it stops.
+		*/
+		virtual void Step(const char *& in, const char *in_end, char *& out, char *out_end) = 0;
+
+		/// Whether the input consumed so far ends at the end of a frame.
+		virtual bool AtEnd() const = 0;
+	};
+}
+
+namespace
+{
+	class PlainCodec : public detail::Codec
+	{
+	public:
+		void Step(const char *& in, const char *in_end, char *& out, char *out_end) override
+		{
+			std::size_t len = std::min(in_end - in, out_end - out);
+			std::memcpy(out, in, len);
+			in  += len;
+			out += len;
+		}
+
+		bool AtEnd() const override
+		{
+			return true;
+		}
+	};
+
+#ifdef AUTOJSON_HAVE_ZLIB
+	class GzipCodec : public detail::Codec
+	{
+	public:
+		GzipCodec() : m_zs(), m_end(false)
+		{
+			// gzip header only
+			if (::inflateInit2(&m_zs, 16 + MAX_WBITS) != Z_OK)
+				throw DecompressError() << MessageInfo("inflateInit2() failed");
+		}
+
+		~GzipCodec()
+		{
+			::inflateEnd(&m_zs);
+		}
+
+		void Step(const char *& in, const char *in_end, char *& out, char *out_end) override
+		{
+			// a gzip file may have more than one member
+			if (m_end && in != in_end)
+			{
+				::inflateReset(&m_zs);
+				m_end = false;
+			}
+			if (m_end)
+				return;
+
+			m_zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+			m_zs.avail_in  = static_cast<uInt>(std::min<std::size_t>(in_end - in, UINT_MAX));
+			m_zs.next_out  = reinterpret_cast<Bytef*>(out);
+			m_zs.avail_out = static_cast<uInt>(std::min<std::size_t>(out_end - out, UINT_MAX));
+
+			int result = ::inflate(&m_zs, Z_NO_FLUSH);
+			if (result == Z_STREAM_END)
+				m_end = true;
+			else if (result != Z_OK && result != Z_BUF_ERROR)
+				throw DecompressError() << MessageInfo(m_zs.msg ? m_zs.msg : "inflate() failed");
+
+			in  = reinterpret_cast<const char*>(m_zs.next_in);
+			out = reinterpret_cast<char*>(m_zs.next_out);
+		}
+
+		bool AtEnd() const override
+		{
+			return m_end;
+		}
+
+	private:
+		z_stream	m_zs;
+		bool		m_end;	//!< at the end of a member
+	};
+#endif
+
+#ifdef AUTOJSON_HAVE_ZSTD
+	class ZstdCodec : public detail::Codec
+	{
+	public:
+		ZstdCodec() : m_ds(::ZSTD_createDStream()), m_end(true)
+		{
+			if (!m_ds)
+				throw DecompressError() << MessageInfo("ZSTD_createDStream() failed");
+			::ZSTD_initDStream(m_ds);
+		}
+
+		~ZstdCodec()
+		{
+			::ZSTD_freeDStream(m_ds);
+		}
+
+		void Step(const char *& in, const char *in_end, char *& out, char *out_end) override
+		{
+			// the frame is fully flushed when it ends, and the next frame
+			// starts with more input
+			if (m_end && in == in_end)
+				return;
+
+			ZSTD_inBuffer  src{in, static_cast<std::size_t>(in_end - in), 0};
+			ZSTD_outBuffer dst{out, static_cast<std::size_t>(out_end - out), 0};
+
+			// frames are decoded one after another
+			std::size_t result = ::ZSTD_decompressStream(m_ds, &dst, &src);
+			if (::ZSTD_isError(result))
+				throw DecompressError() << MessageInfo(::ZSTD_getErrorName(result));
+
+			m_end = (result == 0);
+			in  += src.pos;
+			out += dst.pos;
+		}
+
+		bool AtEnd() const override
+		{
+			return m_end;
+		}
+
+	private:
+		ZSTD_DStream	*m_ds;
+		bool			m_end;	//!< at the end of a frame
+	};
+#endif
+
+	const unsigned char gzip_magic[] = {0x1f, 0x8b};
+	const unsigned char zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+	template <std::size_t n>
+	bool StartsWith(const std::vector<char>& buf, std::size_t len, const unsigned char (&magic)[n])
+	{
+		return len >= n && std::memcmp(buf.data(), magic, n) == 0;
+	}
+}
+
+const std::size_t Decompressor::default_chunk_size;
+
+/**	Checks if a format is supported by this build.
+*/
+bool Decompressor::IsSupported(Format format)
+{
+	switch (format)
+	{
+#ifdef AUTOJSON_HAVE_ZLIB
+		case Format::gzip:	return true;
+#endif
+#ifdef AUTOJSON_HAVE_ZSTD
+		case Format::zstd:	return true;
+#endif
+		case Format::plain:	return true;
+		default:			return false;
+	}
+}
+
+/**	Constructs a decompressor that reads from a file descriptor.
+
+	\param	fd		The file descriptor, which will not be closed.
+	\param	chunk	Size of the buffer of compressed input.
+*/
+Decompressor::Decompressor(int fd, std::size_t chunk) :
+	m_fd(fd),
+	m_format(Format::unknown),
+	m_in(chunk),
+	m_pos(0),
+	m_len(0),
+	m_eof(false)
+{
+	assert(chunk >= sizeof(zstd_magic));
+}
+
+Decompressor::~Decompressor()
+{
+}
+
+/**	Decompresses the input to a buffer.
+
+	Read() may return before the buffer is full when all input read so far is
+	decompressed, so the data can be parsed without waiting for a slow input.
+
+	\return	The number of bytes written to the buffer, or zero at the end of the
+			input.
+	\throw	DecompressError if the input is corrupted or ends in the middle of
+			a frame, or FileError if the file descriptor cannot be read.
+*/
+std::size_t Decompressor::Read(char *buf, std::size_t size)
+{
+	if (m_format == Format::unknown)
+		Detect();
+
+	char *out = buf;
+	while (out != buf + size)
+	{
+		const char *in = m_in.data() + m_pos;
+		char *prev = out;
+		m_codec->Step(in, m_in.data() + m_len, out, buf + size);
+
+		bool progress = (out != prev || in != m_in.data() + m_pos);
+		m_pos = static_cast<std::size_t>(in - m_in.data());
+
+		if (!progress)
+		{
+			// the codec stops only if it needs more input
+			assert(m_pos == m_len);
+			if (out != buf)
+				break;
+
+			if (!Fill())
+			{
+				if (!m_codec->AtEnd())
+					throw DecompressError() << MessageInfo("unexpected end of input");
+				break;
+			}
+		}
+	}
+	return static_cast<std::size_t>(out - buf);
+}
+
+Decompressor::Format Decompressor::GetFormat() const
+{
+	return m_format;
+}
+
+/**	Reads more compressed input after the input in the buffer.
+
+	\return	false at the end of file.
+*/
+bool Decompressor::Fill()
+{
+	if (m_eof)
+		return false;
+	if (m_pos == m_len)
+		m_pos = m_len = 0;
+	assert(m_len < m_in.size());
+
+	std::size_t len = ReadFd(m_fd, m_in.data() + m_len, m_in.size() - m_len);
+	m_len += len;
+	m_eof = (len == 0);
+	return !m_eof;
+}
+
+/**	Detects the format by the magic number and creates the codec for it.
+*/
+void Decompressor::Detect()
+{
+	while (m_len < sizeof(zstd_magic) && Fill())
+	{
+	}
+
+	Format format = Format::plain;
+	if (StartsWith(m_in, m_len, gzip_magic))
+		format = Format::gzip;
+	else if (StartsWith(m_in, m_len, zstd_magic))
+		format = Format::zstd;
+
+	// the format is set only with its codec, so Read() keeps throwing for an
+	// unsupported format
+	switch (format)
+	{
+#ifdef AUTOJSON_HAVE_ZLIB
+		case Format::gzip:	m_codec.reset(new GzipCodec);	break;
+#endif
+#ifdef AUTOJSON_HAVE_ZSTD
+		case Format::zstd:	m_codec.reset(new ZstdCodec);	break;
+#endif
+		case Format::plain:	m_codec.reset(new PlainCodec);	break;
+		default:
+			throw DecompressError() << MessageInfo(format == Format::gzip ?
+				"gzip is not supported" : "zstd is not supported");
+	}
+	m_format = format;
+}
+
+} // end of namespace
@@ -0,0 +1,116 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef DECOMPRESSOR_HH_INCLUDED
+#define DECOMPRESSOR_HH_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace json {
+
+namespace detail
+{
+	class Codec;
+}
+
+/**	Decompresses gzip or zstd input in chunks.
+
+	The format is detected by the magic number at the start of the input.
+	Input that is not compressed is passed through. gzip needs zlib and zstd
+	needs libzstd when autojson is built; they are used if CMake finds them.
+	A DecompressError is thrown for a format that is not supported by the
+	build, or for corrupted or truncated input.
+
+	Read() decompresses directly into the buffer given by the caller, so the
+	decompressed file is never kept in memory as a whole. The buffer can be
+	given to a parser right away:
+
+	\code{.cpp}
+	Decompressor input(fd);
+	input.Feed(parser);
+	\endcode
+
+	Read() can also be the Source of a ReadAhead, which decompresses on the
+	I/O thread while the parser runs on the calling thread:
+
+	\code{.cpp}
+	Decompressor input(fd);
+	ReadAhead chunks([&input](char *buf, std::size_t size){ return input.Read(buf, size); });
+	chunks.Feed(parser);
+	\endcode
+*/
+class Decompressor
+{
+public:
+	enum class Format
+	{
+		unknown,	//!< not detected yet
+		plain,
+		gzip,
+		zstd
+	};
+
+	static const std::size_t default_chunk_size = 64 * 1024;
+
+	static bool IsSupported(Format format);
+
+public:
+	explicit Decompressor(int fd, std::size_t chunk = default_chunk_size);
+	~Decompressor();
+
+	Decompressor(const Decompressor&) = delete;
+	Decompressor& operator=(const Decompressor&) = delete;
+
+	std::size_t Read(char *buf, std::size_t size);
+	Format GetFormat() const;
+
+	/**	Gives all decompressed data to the Parse() function of \a parser, one
+		window at a time.
+	*/
+	template <typename Parser>
+	void Feed(Parser& parser, std::size_t window = default_chunk_size)
+	{
+		std::vector<char> buf(window);
+		for (std::size_t len ; (len = Read(buf.data(), buf.size())) > 0 ; )
+			parser.Parse(buf.data(), len);
+	}
+
+private:
+	bool Fill();
+	void Detect();
+
+private:
+	const int			m_fd;
+	Format				m_format;
+
+	// compressed input
+	std::vector<char>	m_in;
+	std::size_t			m_pos;
+	std::size_t			m_len;
+	bool				m_eof;
+
+	std::unique_ptr<detail::Codec>	m_codec;
+};
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,76 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Document.hh"
+
+#include <new>
+
+namespace json {
+
+Document::Document(std::size_t block_size) :
+	m_arena(block_size),
+	m_builder(&m_arena)
+{
+	::new(&m_root) JVar;
+}
+
+Document::~Document()
+{
+	// the nodes are released with the Arena
+}
+
+JVar& Document::Root()
+{
+	return *reinterpret_cast<JVar*>(&m_root);
+}
+
+const JVar& Document::Root() const
+{
+	return *reinterpret_cast<const JVar*>(&m_root);
+}
+
+/**	Returns the JVarBuilder that builds the root of the Document from JsonParser.
+*/
+const JVarBuilder* Document::Builder() const
+{
+	return &m_builder;
+}
+
+Arena& Document::GetArena()
+{
+	return m_arena;
+}
+
+/**	Deep copies a value into the Arena so that it can be added to the Document.
+*/
+JVar Document::Import(const JVar& val)
+{
+	return JVar(val, &m_arena);
+}
+
+/**	Empties the Document and releases all its memory.
+*/
+void Document::Clear()
+{
+	::new(&m_root) JVar;
+	m_arena.Release();
+}
+
+} // end of namespace
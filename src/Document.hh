@@ -0,0 +1,76 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef DOCUMENT_HH_INCLUDED
+#define DOCUMENT_HH_INCLUDED
+
+#include "Arena.hh"
+#include "JVar.hh"
+#include "JVarBuilder.hh"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace json {
+
+/**	A JVar tree whose strings, arrays and hashes are allocated from an Arena.
+
+	Building the tree takes a few large allocations instead of one for each
+	node, and destroying the Document releases the whole tree at once without
+	visiting the nodes.
+	
+	\code{.cpp}
+	Document doc;
+	JsonParser parser(doc.Builder());
+	parser.Parse(json, len, &doc.Root());
+	\endcode
+	
+	Since the nodes are never destroyed, everything in the tree must be
+	allocated from the Arena of the Document. Values created elsewhere must be
+	copied in by Import() before they are added to the tree.
+*/
+class Document
+{
+public:
+	explicit Document(std::size_t block_size = 4096);
+	Document(const Document&) = delete;
+	Document& operator=(const Document&) = delete;
+	~Document();
+	
+	JVar& Root();
+	const JVar& Root() const;
+	
+	const JVarBuilder* Builder() const;
+	Arena& GetArena();
+	
+	JVar Import(const JVar& val);
+	void Clear();
+	
+private:
+	Arena		m_arena;
+	JVarBuilder	m_builder;
+	
+	// not destroyed when the Document is destroyed
+	std::aligned_storage<sizeof(JVar), alignof(JVar)>::type	m_root;
+};
+
+} // end of namespace
+
+#endif
@@ -22,9 +22,11 @@
 #define EXCEPTION_HH_INCLUDED
 
 #include <stdexcept>
+#include <string>
 #include <typeindex>
 #include <map>
 #include <memory>
+#include <ostream>
 
 namespace json {
 
@@ -148,6 +150,32 @@ using InvalidCharInfo	= ErrInfo<struct InvalidChar_, char>;
 
 struct InvalidChar : public ParseError {};
 
+using NumberInfo	= ErrInfo<struct Number_, std::string>;
+
+/**	Indicates a number that is too large for the type it is converted to.
+
+	The attribute NumberInfo is the number being converted.
+*/
+struct OutOfRange : public Exception {};
+
+using FileNameInfo	= ErrInfo<struct FileName_, std::string>;
+using ErrnoInfo		= ErrInfo<struct Errno_, int>;
+
+/**	Indicates a file that cannot be opened or read.
+
+	The attributes are FileNameInfo and ErrnoInfo, which is the errno of the
+	system call that failed.
+*/
+struct FileError : public Exception {};
+
+using MessageInfo	= ErrInfo<struct Message_, std::string>;
+
+/**	Indicates compressed input that is corrupted or truncated.
+
+	The attribute MessageInfo is the error message of the decompressor.
+*/
+struct DecompressError : public Exception {};
+
 } // end of namespace
 
 #endif
@@ -0,0 +1,594 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef FLATHASH_HH_INCLUDED
+#define FLATHASH_HH_INCLUDED
+
+#include "Key.hh"
+#include "KeyTable.hh"
+#include "StringView.hh"
+#include "SymbolTable.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+/**	The key of a FlatHash.
+
+	It is either a symbol interned in SymbolTable::Global(), which refers to the
+	string in the table, or a string allocated by the allocator of the key.
+	Comparing two symbols for equality only compares their IDs.
+	
+	\param	A	An allocator of char.
+*/
+template <typename A>
+class HashKey
+{
+public:
+	using allocator_type = A;
+	
+	static const std::uint32_t no_symbol = SymbolTable::npos;
+
+public:
+	explicit HashKey(const A& alloc = A()) :
+		m_str(""), m_size(0), m_symbol(no_symbol), m_alloc(alloc)
+	{
+	}
+	
+	HashKey(const char *str, std::size_t len, const A& alloc = A()) :
+		m_str(""), m_size(static_cast<std::uint32_t>(len)), m_symbol(no_symbol), m_alloc(alloc)
+	{
+		if (len > UINT32_MAX)
+			throw std::length_error("HashKey");
+		
+		if (len > 0)
+		{
+			char *p = std::allocator_traits<A>::allocate(m_alloc, len);
+			std::memcpy(p, str, len);
+			m_str = p;
+		}
+	}
+	
+	HashKey(const StringView& str, const A& alloc = A()) :
+		HashKey(str.data(), str.size(), alloc)
+	{
+	}
+	
+	/**	Creates a symbol, or copies the string of the Key if it is not one.
+	*/
+	HashKey(const Key& key, const A& alloc = A()) :
+		HashKey(key.IsSymbol() ? Symbol(key.SymbolId(), alloc) : HashKey(StringView{key.Data()}, alloc))
+	{
+	}
+	
+	HashKey(const HashKey& other) :
+		HashKey(other, std::allocator_traits<A>::select_on_container_copy_construction(other.m_alloc))
+	{
+	}
+	
+	HashKey(const HashKey& other, const A& alloc) :
+		HashKey(other.IsSymbol() ? Symbol(other.m_symbol, alloc) : HashKey(other.View(), alloc))
+	{
+	}
+	
+	HashKey(HashKey&& other) noexcept :
+		m_str(other.m_str), m_size(other.m_size), m_symbol(other.m_symbol), m_alloc(other.m_alloc)
+	{
+		other.m_str		= "";
+		other.m_size	= 0;
+		other.m_symbol	= no_symbol;
+	}
+	
+	HashKey& operator=(HashKey other) noexcept
+	{
+		std::swap(m_str, other.m_str);
+		std::swap(m_size, other.m_size);
+		std::swap(m_symbol, other.m_symbol);
+		std::swap(m_alloc, other.m_alloc);
+		return *this;
+	}
+	
+	~HashKey()
+	{
+		if (m_symbol == no_symbol && m_size > 0)
+			std::allocator_traits<A>::deallocate(m_alloc, const_cast<char*>(m_str), m_size);
+	}
+	
+	static HashKey Symbol(std::uint32_t id, const A& alloc = A())
+	{
+		HashKey key(alloc);
+		StringView name = SymbolTable::Global().Name(id);
+		key.m_str		= name.data();
+		key.m_size		= static_cast<std::uint32_t>(name.size());
+		key.m_symbol	= id;
+		return key;
+	}
+	
+	const char* data() const		{ return m_str; }
+	std::size_t size() const		{ return m_size; }
+	StringView View() const			{ return StringView{m_str, m_str + m_size}; }
+	
+	bool IsSymbol() const			{ return m_symbol != no_symbol; }
+	std::uint32_t SymbolId() const	{ return m_symbol; }
+	
+	A get_allocator() const			{ return m_alloc; }
+	
+private:
+	const char		*m_str;
+	std::uint32_t	m_size;
+	std::uint32_t	m_symbol;	//!< ID in SymbolTable::Global(), or no_symbol if the string is owned
+	A				m_alloc;
+};
+
+template <typename A>
+const std::uint32_t HashKey<A>::no_symbol;
+
+template <typename A>
+bool operator==(const HashKey<A>& k1, const HashKey<A>& k2)
+{
+	return k1.IsSymbol() && k2.IsSymbol() ? k1.SymbolId() == k2.SymbolId() : k1.View() == k2.View();
+}
+
+template <typename A>
+bool operator!=(const HashKey<A>& k1, const HashKey<A>& k2)
+{
+	return !(k1 == k2);
+}
+
+template <typename A>
+std::ostream& operator<<(std::ostream& os, const HashKey<A>& key)
+{
+	return os << key.View();
+}
+
+/**	A map from strings to T stored in a vector sorted by the keys.
+
+	Small hashes are looked up by binary search. When there are more than
+	index_threshold entries, an open addressing table of the positions of the
+	entries is kept as well, so a lookup takes one hash calculation and usually
+	one key comparison. The entries are iterated in the order of their keys,
+	like std::map.
+	
+	Append() adds an entry at the end without looking up its key, so a parser
+	can add the members of an object in constant time. Seal() sorts the entries
+	appended and keeps the last value of duplicated keys. Lookups still work
+	before Seal(), but the unsorted entries are searched linearly.
+	
+	The keys can be symbols of SymbolTable::Global(). Looking up a symbol Key
+	only compares IDs with the keys that are symbols too, and uses the hash
+	stored in the table instead of hashing the string again.
+	
+	Unlike std::map, adding or erasing entries invalidates the iterators and
+	references to the other entries. Keys must not be modified by iterators.
+	
+	\param	T	The type of the values.
+	\param	A	An allocator. It is rebound for the keys, entries and index.
+*/
+template <typename T, typename A=std::allocator<T>>
+class FlatHash
+{
+private:
+	template <typename U>
+	using Rebind = typename std::allocator_traits<A>::template rebind_alloc<U>;
+
+public:
+	using key_type			= HashKey<Rebind<char>>;
+	using mapped_type		= T;
+	using value_type		= std::pair<key_type, T>;
+	using allocator_type	= Rebind<value_type>;
+	using size_type			= std::size_t;
+
+private:
+	using Entries	= std::vector<value_type, allocator_type>;
+	using Index		= std::vector<std::uint32_t, Rebind<std::uint32_t>>;
+
+public:
+	using iterator			= typename Entries::iterator;
+	using const_iterator	= typename Entries::const_iterator;
+	
+	//! Hashes with more entries than this are indexed.
+	static const std::size_t index_threshold = 16;
+
+public:
+	explicit FlatHash(const allocator_type& alloc = allocator_type()) :
+		m_entries(alloc),
+		m_index(alloc),
+		m_sorted(0)
+	{
+	}
+	
+	FlatHash(const FlatHash& other) = default;
+	FlatHash& operator=(const FlatHash& other) = default;
+	
+	FlatHash(const FlatHash& other, const allocator_type& alloc) :
+		m_entries(other.m_entries, alloc),
+		m_index(other.m_index, alloc),
+		m_sorted(other.m_sorted)
+	{
+	}
+	
+	FlatHash(FlatHash&& other) noexcept :
+		m_entries(std::move(other.m_entries)),
+		m_index(std::move(other.m_index)),
+		m_sorted(other.m_sorted)
+	{
+		other.clear();
+	}
+	
+	FlatHash(FlatHash&& other, const allocator_type& alloc) :
+		m_entries(std::move(other.m_entries), alloc),
+		m_index(std::move(other.m_index), alloc),
+		m_sorted(other.m_sorted)
+	{
+		other.clear();
+	}
+	
+	FlatHash& operator=(FlatHash&& other) noexcept
+	{
+		m_entries	= std::move(other.m_entries);
+		m_index		= std::move(other.m_index);
+		m_sorted	= other.m_sorted;
+		other.clear();
+		return *this;
+	}
+	
+	iterator begin()				{ return m_entries.begin(); }
+	iterator end()					{ return m_entries.end(); }
+	const_iterator begin() const	{ return m_entries.begin(); }
+	const_iterator end() const		{ return m_entries.end(); }
+	const_iterator cbegin() const	{ return m_entries.cbegin(); }
+	const_iterator cend() const		{ return m_entries.cend(); }
+	
+	size_type size() const			{ return m_entries.size(); }
+	bool empty() const				{ return m_entries.empty(); }
+	void reserve(size_type n)		{ m_entries.reserve(n); }
+	
+	allocator_type get_allocator() const
+	{
+		return m_entries.get_allocator();
+	}
+	
+	iterator find(const StringView& key)
+	{
+		return m_entries.begin() + Find(key, key_type::no_symbol);
+	}
+	
+	const_iterator find(const StringView& key) const
+	{
+		return m_entries.begin() + Find(key, key_type::no_symbol);
+	}
+	
+	iterator find(const Key& key)
+	{
+		return m_entries.begin() + Find(key);
+	}
+	
+	const_iterator find(const Key& key) const
+	{
+		return m_entries.begin() + Find(key);
+	}
+	
+	template <typename K>
+	size_type count(const K& key) const
+	{
+		return find(key) != end() ? 1 : 0;
+	}
+	
+	template <typename K>
+	T& at(const K& key)
+	{
+		auto it = find(key);
+		if (it == end())
+			throw std::out_of_range("FlatHash::at");
+		return it->second;
+	}
+	
+	template <typename K>
+	const T& at(const K& key) const
+	{
+		auto it = find(key);
+		if (it == end())
+			throw std::out_of_range("FlatHash::at");
+		return it->second;
+	}
+	
+	T& operator[](const StringView& key)
+	{
+		Seal();
+		
+		std::size_t pos = Find(key, key_type::no_symbol);
+		return pos != m_entries.size() ?
+			m_entries[pos].second :
+			Insert(key_type(key, get_allocator()))->second;
+	}
+	
+	T& operator[](const Key& key)
+	{
+		Seal();
+		
+		std::size_t pos = Find(key);
+		return pos != m_entries.size() ?
+			m_entries[pos].second :
+			Insert(key_type(key, get_allocator()))->second;
+	}
+	
+	T& operator[](key_type&& key)
+	{
+		return emplace(std::move(key)).first->second;
+	}
+	
+	/**	Adds an entry if the key is not in the hash. The value is constructed
+		from args.
+		
+		\return	The entry of the key, and whether it was added.
+	*/
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(key_type&& key, Args&&... args)
+	{
+		Seal();
+		
+		std::size_t pos = Find(key.View(), key.SymbolId());
+		if (pos != m_entries.size())
+			return std::make_pair(m_entries.begin() + pos, false);
+		
+		return std::make_pair(Insert(std::move(key), std::forward<Args>(args)...), true);
+	}
+	
+	/**	Adds an entry at the end without looking up the key. Call Seal() after
+		appending to sort the entries and remove the duplicated keys.
+		
+		\return	The value of the entry, which is constructed from args.
+	*/
+	template <typename... Args>
+	T& Append(key_type&& key, Args&&... args)
+	{
+		// keys appended in order do not need to be sorted again
+		bool in_order = m_sorted == m_entries.size() &&
+			(m_entries.empty() || View(m_entries.back().first) < View(key));
+		
+		m_entries.emplace_back(std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)),
+			std::forward_as_tuple(std::forward<Args>(args)...));
+		
+		if (in_order)
+			AddLast();
+		return m_entries.back().second;
+	}
+	
+	/**	Sorts the entries added by Append(). If a key was appended more than
+		once, the last value is kept.
+	*/
+	void Seal()
+	{
+		if (m_sorted == m_entries.size())
+			return;
+		
+		// the appended entries go after the sorted ones with the same key
+		std::stable_sort(m_entries.begin() + m_sorted, m_entries.end(), &Less);
+		std::inplace_merge(m_entries.begin(), m_entries.begin() + m_sorted, m_entries.end(), &Less);
+		
+		auto out = m_entries.begin();
+		for (auto it = m_entries.begin() ; it != m_entries.end() ; ++it)
+		{
+			auto next = it + 1;
+			if (next == m_entries.end() || View(next->first) != View(it->first))
+			{
+				if (out != it)
+					*out = std::move(*it);
+				++out;
+			}
+		}
+		m_entries.erase(out, m_entries.end());
+		
+		m_sorted = m_entries.size();
+		Reindex();
+	}
+	
+	iterator erase(const_iterator pos)
+	{
+		std::size_t i = static_cast<std::size_t>(pos - m_entries.cbegin());
+		auto it = m_entries.erase(m_entries.begin() + i);
+		if (i < m_sorted)
+		{
+			--m_sorted;
+			Reindex();
+		}
+		return it;
+	}
+	
+	size_type erase(const StringView& key)
+	{
+		Seal();
+		
+		std::size_t pos = Find(key, key_type::no_symbol);
+		if (pos == m_entries.size())
+			return 0;
+		
+		erase(m_entries.begin() + pos);
+		return 1;
+	}
+	
+	void clear()
+	{
+		m_entries.clear();
+		m_index.clear();
+		m_sorted = 0;
+	}
+	
+private:
+	static StringView View(const key_type& key)
+	{
+		return key.View();
+	}
+	
+	static bool Less(const value_type& e1, const value_type& e2)
+	{
+		return View(e1.first) < View(e2.first);
+	}
+	
+	static bool Equal(const key_type& k, const StringView& key, std::uint32_t symbol)
+	{
+		return k.IsSymbol() && symbol != key_type::no_symbol ? k.SymbolId() == symbol : k.View() == key;
+	}
+	
+	std::size_t Find(const Key& key) const
+	{
+		return key.IsSymbol() ?
+			Find(key.Data(), key.SymbolId()) :
+			Find(key.Data(), key_type::no_symbol);
+	}
+	
+	/**	Looks up a key, which may be a symbol.
+		
+		\return	The position of the key, or size() if it is not found.
+	*/
+	std::size_t Find(const StringView& key, std::uint32_t symbol) const
+	{
+		// the appended entries are newer than the sorted ones
+		for (std::size_t i = m_entries.size() ; i > m_sorted ; --i)
+			if (Equal(m_entries[i-1].first, key, symbol))
+				return i-1;
+		
+		if (m_index.empty())
+		{
+			// comparing IDs is faster than a binary search of strings
+			if (symbol != key_type::no_symbol)
+			{
+				for (std::size_t pos = 0 ; pos < m_sorted ; ++pos)
+					if (Equal(m_entries[pos].first, key, symbol))
+						return pos;
+				return m_entries.size();
+			}
+			
+			std::size_t pos = LowerBound(key);
+			return pos < m_sorted && View(m_entries[pos].first) == key ? pos : m_entries.size();
+		}
+		
+		std::size_t mask = m_index.size() - 1;
+		for (std::size_t slot = Slot(key, symbol) ; m_index[slot] != 0 ; slot = (slot + 1) & mask)
+		{
+			std::size_t pos = m_index[slot] - 1;
+			if (Equal(m_entries[pos].first, key, symbol))
+				return pos;
+		}
+		return m_entries.size();
+	}
+	
+	//! Returns the position of the first sorted entry not less than the key.
+	std::size_t LowerBound(const StringView& key) const
+	{
+		auto it = std::lower_bound(m_entries.begin(), m_entries.begin() + m_sorted, key,
+			[](const value_type& e, const StringView& k) { return View(e.first) < k; });
+		return static_cast<std::size_t>(it - m_entries.begin());
+	}
+	
+	//! Inserts a new key in order. There must be no appended entries.
+	template <typename... Args>
+	iterator Insert(key_type&& key, Args&&... args)
+	{
+		assert(m_sorted == m_entries.size());
+		
+		std::size_t pos = LowerBound(View(key));
+		auto it = m_entries.emplace(m_entries.begin() + pos, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)),
+			std::forward_as_tuple(std::forward<Args>(args)...));
+		
+		// entries after pos are moved, so their positions in the index change
+		if (pos + 1 == m_entries.size())
+			AddLast();
+		else
+		{
+			++m_sorted;
+			Reindex();
+		}
+		return it;
+	}
+	
+	//! Adds the last entry, which is greater than all sorted entries, to the index.
+	void AddLast()
+	{
+		++m_sorted;
+		if (m_sorted > index_threshold && m_sorted * 2 <= m_index.size())
+			IndexEntry(m_sorted - 1);
+		else
+			Reindex();
+	}
+	
+	void Reindex()
+	{
+		m_index.clear();
+		if (m_sorted <= index_threshold)
+			return;
+		
+		assert(m_sorted < UINT32_MAX);
+		
+		// at most a quarter full, so the keys appended later fit
+		std::size_t slots = 1;
+		while (slots < m_sorted * 4)
+			slots <<= 1;
+		
+		m_index.assign(slots, 0);
+		for (std::size_t pos = 0 ; pos < m_sorted ; ++pos)
+			IndexEntry(pos);
+	}
+	
+	void IndexEntry(std::size_t pos)
+	{
+		std::size_t mask = m_index.size() - 1;
+		const key_type& key = m_entries[pos].first;
+		std::size_t slot = Slot(key.View(), key.SymbolId());
+		while (m_index[slot] != 0)
+			slot = (slot + 1) & mask;
+		
+		m_index[slot] = static_cast<std::uint32_t>(pos + 1);
+	}
+	
+	std::size_t Slot(const StringView& key, std::uint32_t symbol) const
+	{
+		std::uint64_t hash = symbol != key_type::no_symbol ?
+			SymbolTable::Global().Hash(symbol) :
+			KeyTable::Hash(key.data(), key.size(), 0);
+		
+		return static_cast<std::size_t>(hash) & (m_index.size() - 1);
+	}
+	
+private:
+	Entries		m_entries;
+	Index		m_index;	//!< positions of the sorted entries plus one, or zero for empty slots
+	std::size_t	m_sorted;	//!< number of entries sorted and indexed
+};
+
+template <typename T, typename A>
+const std::size_t FlatHash<T, A>::index_threshold;
+
+} // end of namespace
+
+#endif
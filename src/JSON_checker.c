@@ -199,6 +199,7 @@ reject(JSON_checker jc)
 /*
     Delete the JSON_checker object.
 */
+    free((void*)jc->token);
     free((void*)jc->stack);
     free((void*)jc);
     return false;
@@ -242,7 +243,9 @@ new_JSON_checker(int depth)
     jc->depth = depth;
     jc->top = -1;
     jc->stack = (int*)calloc(depth, sizeof(int));
+	jc->token = 0;
 	jc->token_len = 0;
+	jc->token_cap = 0;
     push(jc, MODE_DONE);
     return jc;
 }
@@ -254,14 +257,40 @@ typedef struct JSON_token_
 	void			*user;
 } JSON_token;
 
-static void emit_token(JSON_checker jc, JSON_token *token, const char *pos, JSON_event type)
+/* append len characters to the saved token, growing it if needed */
+static int append_token(JSON_checker jc, const char *start, size_t len)
 {
-	int len = (int)(pos - token->start);
-	if (jc->token_len > 0 && sizeof(jc->token) - jc->token_len > len )
+	size_t need = jc->token_len + len;
+	if (need > jc->token_cap)
 	{
-		assert(token->start != 0);
-		memcpy(jc->token + jc->token_len, token->start, len);
-		(token->cb)(token->user, type, jc->token, jc->token_len + len);
+		size_t cap = jc->token_cap > 0 ? jc->token_cap : 64;
+		char *token;
+		while (cap < need)
+			cap *= 2;
+		
+		token = (char*)realloc(jc->token, cap);
+		if (token == 0)
+			return false;
+		jc->token = token;
+		jc->token_cap = cap;
+	}
+	
+	if (len > 0)
+		memcpy(jc->token + jc->token_len, start, len);
+	jc->token_len = need;
+	return true;
+}
+
+static int emit_token(JSON_checker jc, JSON_token *token, const char *pos, JSON_event type)
+{
+	// the token may have ended right at the start of this chunk, with all of
+	// its characters saved from the previous chunks
+	size_t len = token->start != 0 ? (size_t)(pos - token->start) : 0;
+	if (jc->token_len > 0)
+	{
+		if (!append_token(jc, token->start, len))
+			return false;
+		(token->cb)(token->user, type, jc->token, jc->token_len);
 	}
 	else
 		(token->cb)(token->user, type, len == 0 ? 0 : token->start, len);
@@ -269,6 +298,7 @@ static void emit_token(JSON_checker jc, JSON_token *token, const char *pos, JSON
 	// reset
 	jc->token_len = 0;
 	token->start = 0;
+	return true;
 }
 
 static void emit_permitive(JSON_checker jc, JSON_token *token, JSON_event type)
@@ -295,11 +325,11 @@ static void save_char(JSON_checker jc, const char *ptr, JSON_token *token, int n
 	}
 }
 
-static void detect_state(JSON_checker jc, const char *pos, int next_state, JSON_token *token)
+static int detect_state(JSON_checker jc, const char *pos, int next_state, JSON_token *token)
 {
 	// state from number to non-number
 	if ( (is_number(jc->state) && !is_number(next_state)))
-		emit_token(jc, token, pos, JSON_number);
+		return emit_token(jc, token, pos, JSON_number);
 	
 	else if (jc->state == N3 && next_state == OK)
 		emit_permitive(jc, token, JSON_null);
@@ -309,23 +339,15 @@ static void detect_state(JSON_checker jc, const char *pos, int next_state, JSON_
 	
 	else if (jc->state == F4 && next_state == OK)
 		emit_permitive(jc, token, JSON_false);
+	
+	return true;
 }
 
 static int save_token(JSON_checker jc, JSON_token *token, const char *pos)
 {
 	// save the rest of the token string in the parser state
 	if (token->start != 0)
-	{
-		char *p = &jc->token[jc->token_len];
-		size_t len = pos - token->start;
-		if (sizeof(jc->token) > len)
-		{
-			memcpy(p, token->start, len);
-			jc->token_len += len;
-		}
-		else
-			reject(jc);
-	}
+		return append_token(jc, token->start, (size_t)(pos - token->start));
 	return true;
 }
 
@@ -368,7 +390,9 @@ JSON_checker_char(JSON_checker jc, const char *chars, size_t len, JSON_callback
 
 		// check if need to save the character for consuming and any state change
 		save_char(jc, &chars[i], &token, next_class, next_state);
-		detect_state(jc, &chars[i], next_state, &token);
+		if (!detect_state(jc, &chars[i], next_state, &token)) {
+			return reject(jc);
+		}
 
 		if (next_state >= 0) {
 	/*
@@ -425,12 +449,16 @@ JSON_checker_char(JSON_checker jc, const char *chars, size_t len, JSON_callback
 				switch (jc->stack[jc->top]) {
 				case MODE_KEY:
 					jc->state = CO;
-					emit_token(jc, &token, &chars[i], JSON_object_key);
+					if (!emit_token(jc, &token, &chars[i], JSON_object_key)) {
+						return reject(jc);
+					}
 					break;
 				case MODE_ARRAY:
 				case MODE_OBJECT:
 					jc->state = OK;
-					emit_token(jc, &token, &chars[i], JSON_string);
+					if (!emit_token(jc, &token, &chars[i], JSON_string)) {
+						return reject(jc);
+					}
 					break;
 				default:
 					return reject(jc);
@@ -478,7 +506,9 @@ JSON_checker_char(JSON_checker jc, const char *chars, size_t len, JSON_callback
 		}
 	}
 	
-	save_token(jc, &token, &chars[i]);
+	if (!save_token(jc, &token, &chars[i])) {
+		return reject(jc);
+	}
 	
     return true;
 }
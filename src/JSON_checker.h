@@ -69,8 +69,9 @@ typedef struct JSON_checker_struct {
     int top;
     int* stack;
 
-	char token[1024];
+	char *token;		/* the part of a token saved from the previous chunks */
 	size_t token_len;
+	size_t token_cap;	/* grows to hold the longest token so far */
 
 } * JSON_checker;
 
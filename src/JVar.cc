@@ -19,127 +19,468 @@
 */
 
 #include "JVar.hh"
+#include "Writer.hh"
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <typeinfo>
 #include <ostream>
+#include <string>
+#include <utility>
 
 namespace json {
 
-JVar::JVar(json::Type type) : m_type(type)
+static_assert(sizeof(JVar) == 16, "JVar should take 16 bytes");
+
+//! A reference counted container of a shared JVar.
+template <typename T>
+struct JVar::Shared
 {
-	// deep copy
-	switch (m_type)
+	template <typename... Args>
+	explicit Shared(Args&&... args) : refs(1), value(std::forward<Args>(args)...)
 	{
-	case json::Type::string:	m_raw.string = new std::string;	break;
-	case json::Type::array:	m_raw.array	 = new Array;		break;
-	case json::Type::hash:	m_raw.hash	 = new Hash;		break;
-	default:	break;
 	}
+	
+	std::atomic<std::size_t>	refs;
+	T							value;
+};
+
+namespace
+{
+	// Creates the container of a JVar. The container itself and its contents
+	// are allocated from the arena, or the heap if arena is null.
+	template <typename T, typename... Args>
+	T* New(Arena *arena, Args&&... args)
+	{
+		ArenaAllocator<T> alloc(arena);
+		T *p = alloc.allocate(1);
+		try
+		{
+			return ::new(p) T(std::forward<Args>(args)..., ArenaAllocator<typename T::value_type>(arena));
+		}
+		catch (...)
+		{
+			alloc.deallocate(p, 1);
+			throw;
+		}
+	}
+	
+	template <typename T>
+	void Delete(T *p)
+	{
+		ArenaAllocator<T> alloc(p->get_allocator());
+		p->~T();
+		alloc.deallocate(p, 1);
+	}
+}
+
+JVar::JVar(json::Type type) : JVar(type, nullptr)
+{
+}
+
+/**	Creates an empty value of the type. Arrays and hashes will be allocated
+	from the arena when elements are added to them.
+*/
+JVar::JVar(json::Type type, Arena *arena)
+{
+	m_raw.word.type		= type;
+	m_raw.word.flag		= 0;
+	m_raw.word.arena	= arena;
+	
+	if (type == json::Type::integer)
+		m_raw.word.integer = 0;
+	else if (type == json::Type::real)
+		m_raw.word.real = 0.0;
+	else if (type == json::Type::boolean)
+		m_raw.word.boolean = false;
+}
+
+JVar::JVar(const JVar& val) : JVar(val, nullptr)
+{
 }
 
-JVar::JVar(const JVar& val) : m_type(val.m_type), m_raw(val.m_raw)
+/**	Deep copies a value to an arena, or the heap if arena is null. Shared
+	values are not copied unless an arena is given.
+*/
+JVar::JVar(const JVar& val, Arena *arena) : m_raw(val.m_raw)
 {
-	// deep copy
-	switch (m_type)
+	if (arena == nullptr && val.IsShared())
+	{
+		switch (Type())
+		{
+		case json::Type::string:	m_raw.word.string->refs.fetch_add(1, std::memory_order_relaxed);		break;
+		case json::Type::array:		m_raw.word.shared_array->refs.fetch_add(1, std::memory_order_relaxed);	break;
+		case json::Type::hash:		m_raw.word.shared_hash->refs.fetch_add(1, std::memory_order_relaxed);	break;
+		default:	break;
+		}
+		return;
+	}
+	
+	switch (Type())
 	{
-	case json::Type::string:	m_raw.string = new std::string(*val.m_raw.string);	break;
-	case json::Type::array:		m_raw.array	 = new Array(*val.m_raw.array);			break;
-	case json::Type::hash:		m_raw.hash	 = new Hash(*val.m_raw.hash);			break;
+	case json::Type::string:
+		if (m_raw.word.flag == long_string || m_raw.word.flag == shared_string)
+		{
+			m_raw.word.flag = 0;
+			*this = JVar(val.m_raw.word.string->data, val.m_raw.word.string->size, arena);
+		}
+		break;
+	
+	case json::Type::array:
+		m_raw.word.flag  = 0;
+		m_raw.word.arena = arena;
+		if (val.Size() > 0)
+		{
+			Array& array = AsArray();
+			array.reserve(val.Size());
+			for (const auto& e : val.AsArray())
+				array.emplace_back(e, arena);
+		}
+		break;
+	
+	case json::Type::hash:
+		m_raw.word.flag  = 0;
+		m_raw.word.arena = arena;
+		if (val.Size() > 0)
+		{
+			Hash& hash = AsHash();
+			hash.reserve(val.Size());
+			for (const auto& e : val.AsHash())
+				hash.Append(Hash::key_type(e.first, arena), e.second, arena);
+			hash.Seal();
+		}
+		break;
+	
 	default:	break;
 	}
 }
 
-JVar::JVar(JVar&& val) : JVar(json::Type::null)
+// noexcept, so that vectors move their elements instead of copying them
+JVar::JVar(JVar&& val) noexcept : JVar(json::Type::null)
 {
 	Swap(val);
 }
 
-JVar::JVar(int val) : m_type(json::Type::integer)
+JVar::JVar(int val) : JVar(static_cast<long long>(val))
+{
+}
+
+JVar::JVar(long long val) : JVar(json::Type::integer)
 {
-	m_raw.integer = val;
+	m_raw.word.integer = val;
 }
 
-JVar::JVar(long long val) : m_type(json::Type::integer)
+JVar::JVar(double val) : JVar(json::Type::real)
 {
-	m_raw.integer = val;
+	m_raw.word.real = val;
 }
 
-JVar::JVar(double val) : m_type(json::Type::real)
+JVar::JVar(bool val) : JVar(json::Type::boolean)
 {
-	m_raw.real = val;
+	m_raw.word.boolean = val;
 }
 
-JVar::JVar(bool val) : m_type(json::Type::boolean)
+JVar::JVar(const std::string& val) : JVar(val.data(), val.size())
 {
-	m_raw.boolean = val;
 }
 
-JVar::JVar(const std::string& val) : m_type(json::Type::string)
+JVar::JVar(const char *val) : JVar(val, std::char_traits<char>::length(val))
 {
-	m_raw.string = new std::string(val);
 }
 
-JVar::JVar(std::string&& val) : m_type(json::Type::string)
+JVar::JVar(const StringView& val) : JVar(val.data(), val.size())
 {
-	m_raw.string = new std::string(std::move(val));
 }
 
-JVar::JVar(const char *val) : m_type(json::Type::string)
+/**	Creates a string. Strings longer than 14 characters are allocated from
+	the arena, or the heap if arena is null.
+*/
+JVar::JVar(const char *str, std::size_t len, Arena *arena)
 {
-	m_raw.string = new std::string(val);
+	if (len <= small_string)
+	{
+		m_raw.small.type = json::Type::string;
+		m_raw.small.flag = static_cast<std::uint8_t>(len);
+		if (len > 0)
+			std::memcpy(m_raw.small.chars, str, len);
+	}
+	else
+	{
+		std::size_t bytes = offsetof(LongString, data) + len;
+		void *p = arena ? arena->Allocate(bytes, alignof(LongString)) : ::operator new(bytes);
+		
+		LongString *ls = static_cast<LongString*>(p);
+		ls->arena = arena;
+		ls->size  = len;
+		std::memcpy(ls->data, str, len);
+		
+		m_raw.word.type		= json::Type::string;
+		m_raw.word.flag		= long_string;
+		m_raw.word.string	= ls;
+	}
 }
 
-JVar::JVar(const Array& val) : m_type(json::Type::array)
+JVar::JVar(const Array& val) : JVar(json::Type::array)
 {
-	m_raw.array = new Array(val);
+	m_raw.word.flag  = owned_node;
+	m_raw.word.array = New<Array>(nullptr, val);
 }
 
-JVar::JVar(Array&& val) : m_type(json::Type::array)
+JVar::JVar(Array&& val) : JVar(json::Type::array)
 {
-	m_raw.array = new Array(std::move(val));
+	m_raw.word.flag  = owned_node;
+	m_raw.word.array = New<Array>(val.get_allocator().GetArena(), std::move(val));
 }
 
-JVar::JVar(const Hash& val) : m_type(json::Type::hash)
+JVar::JVar(const Hash& val) : JVar(json::Type::hash)
 {
-	m_raw.hash = new Hash(val);
+	m_raw.word.flag = owned_node;
+	m_raw.word.hash = New<Hash>(nullptr, val);
 }
 
-JVar::JVar(Hash&& val) : m_type(json::Type::hash)
+JVar::JVar(Hash&& val) : JVar(json::Type::hash)
 {
-	m_raw.hash = new Hash(std::move(val));
+	m_raw.word.flag = owned_node;
+	m_raw.word.hash = New<Hash>(val.get_allocator().GetArena(), std::move(val));
 }
 
-void JVar::Swap(JVar& rhs)
+void JVar::Swap(JVar& rhs) noexcept
 {
-	std::swap(m_type, rhs.m_type);
-	std::swap(m_raw,  rhs.m_raw);
+	std::swap(m_raw, rhs.m_raw);
 }
 
 JVar::~JVar()
 {
-	switch (m_type)
+	switch (Type())
 	{
-	case json::Type::string:	delete m_raw.string;	break;
-	case json::Type::array:		delete m_raw.array;		break;
-	case json::Type::hash:		delete m_raw.hash;		break;
+	case json::Type::string:
+		if (m_raw.word.flag == long_string && m_raw.word.string->arena == nullptr)
+			::operator delete(m_raw.word.string);
+		else if (m_raw.word.flag == shared_string &&
+			m_raw.word.string->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			::operator delete(m_raw.word.string);
+		break;
+	
+	case json::Type::array:
+		if (m_raw.word.flag == owned_node)
+			Delete(m_raw.word.array);
+		else if (m_raw.word.flag == shared_node)
+			Release(m_raw.word.shared_array);
+		break;
+	
+	case json::Type::hash:
+		if (m_raw.word.flag == owned_node)
+			Delete(m_raw.word.hash);
+		else if (m_raw.word.flag == shared_node)
+			Release(m_raw.word.shared_hash);
+		break;
+	
 	default:	break;
 	}
 }
 
+/**	Returns the arena of the string, array or hash, or null if it is allocated
+	from the heap or the value is stored inline.
+*/
+Arena* JVar::GetArena() const
+{
+	switch (Type())
+	{
+	case json::Type::string:
+		return m_raw.word.flag == long_string ? m_raw.word.string->arena : nullptr;
+	
+	case json::Type::array:
+		return m_raw.word.flag == owned_node ? m_raw.word.array->get_allocator().GetArena() :
+			(m_raw.word.flag == shared_node ? nullptr : m_raw.word.arena);
+	
+	case json::Type::hash:
+		return m_raw.word.flag == owned_node ? m_raw.word.hash->get_allocator().GetArena() :
+			(m_raw.word.flag == shared_node ? nullptr : m_raw.word.arena);
+	
+	default:	return nullptr;
+	}
+}
+
+/**	Makes the value and all values in it shared, so that copying it takes
+	constant time. Values allocated from an arena are copied to the heap first.
+*/
+JVar& JVar::Share()
+{
+	if (GetArena())
+	{
+		JVar heap(*this, nullptr);
+		Swap(heap);
+	}
+	
+	switch (Type())
+	{
+	case json::Type::string:
+		if (m_raw.word.flag == long_string)
+		{
+			::new(&m_raw.word.string->refs) std::atomic<std::size_t>(1);
+			m_raw.word.flag = shared_string;
+		}
+		break;
+	
+	case json::Type::array:
+		if (m_raw.word.flag == owned_node)
+		{
+			Array *array = m_raw.word.array;
+			for (auto& e : *array)
+				e.Share();
+			
+			m_raw.word.shared_array = new Shared<Array>(std::move(*array));
+			m_raw.word.flag = shared_node;
+			Delete(array);
+		}
+		break;
+	
+	case json::Type::hash:
+		if (m_raw.word.flag == owned_node)
+		{
+			Hash *hash = m_raw.word.hash;
+			for (auto& e : *hash)
+				e.second.Share();
+			
+			m_raw.word.shared_hash = new Shared<Hash>(std::move(*hash));
+			m_raw.word.flag = shared_node;
+			Delete(hash);
+		}
+		break;
+	
+	default:	break;
+	}
+	return *this;
+}
+
+bool JVar::IsShared() const
+{
+	switch (Type())
+	{
+	case json::Type::string:	return m_raw.word.flag == shared_string;
+	case json::Type::array:
+	case json::Type::hash:		return m_raw.word.flag == shared_node;
+	default:					return false;
+	}
+}
+
+/**	Returns the container of a shared node for modification. It is copied if
+	the node is referred to by other JVars. The elements of the copy still
+	share their nodes with the elements of the original.
+*/
+template <typename T>
+T& JVar::Unique(Shared<T> *&node)
+{
+	if (node->refs.load(std::memory_order_acquire) != 1)
+	{
+		Shared<T> *copy = new Shared<T>(node->value);
+		Release(node);
+		node = copy;
+	}
+	return node->value;
+}
+
+template <typename T>
+void JVar::Release(Shared<T> *node)
+{
+	if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete node;
+}
+
+StringView JVar::StringData() const
+{
+	assert(Type() == json::Type::string);
+	
+	if (m_raw.word.flag == long_string || m_raw.word.flag == shared_string)
+	{
+		const LongString *ls = m_raw.word.string;
+		return StringView{ls->data, ls->data + ls->size};
+	}
+	return StringView{m_raw.small.chars, m_raw.small.chars + m_raw.small.flag};
+}
+
+/**	Returns the array, which is allocated when it is first accessed.
+	
+	\throw	int	If the value is not an array.
+*/
+JVar::Array& JVar::AsArray()
+{
+	if (Type() != json::Type::array)
+		throw -1;
+	
+	if (m_raw.word.flag == shared_node)
+		return Unique(m_raw.word.shared_array);
+	
+	if (!m_raw.word.flag)
+	{
+		m_raw.word.array = New<Array>(m_raw.word.arena);
+		m_raw.word.flag  = owned_node;
+	}
+	return *m_raw.word.array;
+}
+
+const JVar::Array& JVar::AsArray() const
+{
+	static const Array empty;
+	
+	if (Type() != json::Type::array)
+		throw -1;
+	
+	switch (m_raw.word.flag)
+	{
+	case owned_node:	return *m_raw.word.array;
+	case shared_node:	return m_raw.word.shared_array->value;
+	default:			return empty;
+	}
+}
+
+JVar::Hash& JVar::AsHash()
+{
+	if (Type() != json::Type::hash)
+		throw -1;
+	
+	if (m_raw.word.flag == shared_node)
+		return Unique(m_raw.word.shared_hash);
+	
+	if (!m_raw.word.flag)
+	{
+		m_raw.word.hash = New<Hash>(m_raw.word.arena);
+		m_raw.word.flag = owned_node;
+	}
+	return *m_raw.word.hash;
+}
+
+const JVar::Hash& JVar::AsHash() const
+{
+	static const Hash empty;
+	
+	if (Type() != json::Type::hash)
+		throw -1;
+	
+	switch (m_raw.word.flag)
+	{
+	case owned_node:	return *m_raw.word.hash;
+	case shared_node:	return m_raw.word.shared_hash->value;
+	default:			return empty;
+	}
+}
+
 json::Type JVar::Type() const
 {
-	return m_type;
+	return m_raw.word.type;
 }
 
 bool JVar::Is(json::Type type) const
 {
-	return m_type == type;
+	return Type() == type;
 }
 
 const JVar& JVar::operator[](const std::string& key) const
 {
-	auto it = AsHash().find(key);
+	auto it = AsHash().find(StringView{key.data(), key.data() + key.size()});
 	if (it == AsHash().end())
 		throw -1;
 	
@@ -148,7 +489,7 @@ const JVar& JVar::operator[](const std::string& key) const
 
 JVar& JVar::operator[](const std::string& key)
 {
-	return AsHash()[key];
+	return AsHash()[StringView{key.data(), key.data() + key.size()}];
 }
 
 const JVar& JVar::operator[](std::size_t idx) const
@@ -186,57 +527,13 @@ std::size_t JVar::Size() const
 	return Apply(SizeOf{}).size;
 }
 
-struct JVar::Printer
-{
-	std::ostream& os;
-	explicit Printer(std::ostream& outs) : os(outs) {}
-
-	template <typename T>
-	void operator()(T i)
-	{
-		os << i;
-	}
-
-	void operator()(const std::string& s)
-	{
-		// will escape later
-		os << '\"' << s << '\"' ;
-	}
-
-	void operator()(bool b)
-	{
-		os << (b ? "true" : "false");
-	}
-
-	void operator()(const Hash& hash)
-	{
-		bool first = true;
-		os << "{";
-		for (const auto& e : hash)
-		{
-			os << (!first ? ", " : "") << e.first << ": " << e.second ;
-			first = false;
-		}
-		os << '}';
-	}
-	
-	void operator()(const Array& array)
-	{
-		bool first = true;
-		os << '[';
-		for (const auto& e : array)
-		{
-			os << (!first ? ", " : "") << e ;
-			first = false;
-		}
-		os << ']';
-	}
-};
-
+/**	Writes the value as compact JSON. See Writer.
+*/
 std::ostream& JVar::Print(std::ostream& os) const
 {
-	Apply(Printer(os));
-	return os;
+	std::string json;
+	Writer(json).Value(*this);
+	return os.write(json.data(), static_cast<std::streamsize>(json.size()));
 }
 
 std::ostream& operator<<(std::ostream& os, const JVar& jv)
@@ -24,7 +24,9 @@
 #include "Type.hh"
 #include "Exception.hh"
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -33,20 +35,40 @@
 namespace json {
 
 /**	A variant class to define the structure of an expected JSON object
+
+	A JVar takes 16 bytes. Numbers, booleans and strings up to 14 characters are
+	stored inline. Longer strings are stored in a single allocation. Arrays and
+	hashes are only allocated when an element is added, so empty ones take no
+	memory. Strings are immutable: they are read as StringView and replaced by
+	assigning a new value. Hashes are FlatHash, which stores the members in a
+	vector sorted by their keys.
+	
+	Strings, arrays and hashes are allocated from the heap by default. A JVar
+	constructed with an Arena allocates them, and their contents, from the Arena
+	instead (see Document). Copying a JVar makes a deep copy on the heap, unless
+	the Arena to copy to is given.
+	
+	Share() turns a value into a shared one. The strings, arrays and hashes of a
+	shared value are reference counted, so copying it takes constant time. They
+	are immutable while they are shared: modifying a shared array or hash copies
+	it first, unless there is no other reference to it. The elements of the
+	copy are still shared. Shared values can be read by many threads without
+	locks. References returned by the non-const accessors of a shared value are
+	only valid until it is copied.
 */
 class JVar
 {
 private :
 	// helpers
-	template <typename T>
+	template <typename T, typename V>
 	struct CheckEqual
 	{
-		explicit CheckEqual(const T& r) : val(r), equal(false) {}
+		explicit CheckEqual(const V& r) : val(r), equal(false) {}
 
-		const T& val;
+		const V& val;
 		bool equal;
 		template <typename U>
-		void operator()(U)			{ equal = false; }
+		void operator()(const U&)	{ equal = false; }
 		void operator()(const T& t)	{ equal = (t == val); }
 	};
 	
@@ -56,22 +78,21 @@ private :
 		explicit GetVal(T *v = nullptr) : val(v) {}
 		T *val;
 		template <typename U>
-		void operator()(U)		{ val = nullptr; }
+		void operator()(U&&)	{ val = nullptr; }
 		void operator()(T& t)	{ val = &t; }
 	};
 	
 	struct ClearComposite;
-	struct Printer;
 	struct SizeOf;
 
 public :
-	typedef std::vector<JVar> 			Array;
-	typedef std::map<std::string, JVar>	Hash;
+	typedef JArray	Array;
+	typedef JHash	Hash;
 
 public :
 	// special member functions
 	JVar(const JVar& rhs);
-	JVar(JVar&& rhs);
+	JVar(JVar&& rhs) noexcept;
 	~JVar();
 	
 	// perfectly forward the argument to the constructor
@@ -85,23 +106,27 @@ public :
 
 	// construction from supported types
 	explicit JVar(json::Type type = json::Type::null);
+	JVar(json::Type type, Arena *arena);
+	JVar(const JVar& rhs, Arena *arena);
 	explicit JVar(int val);
 	explicit JVar(long long val);
 	explicit JVar(double val);
 	explicit JVar(bool val);
 	explicit JVar(const std::string& val);
-	explicit JVar(std::string&& val);
 	explicit JVar(const char *val);
+	explicit JVar(const StringView& val);
+	JVar(const char *str, std::size_t len, Arena *arena = nullptr);
 	explicit JVar(const Array& val);
 	explicit JVar(Array&& val);
 	explicit JVar(const Hash& val);
 	explicit JVar(Hash&& val);
 
 	template <typename T>
-	explicit JVar(const std::vector<T>& vec)
+	explicit JVar(const std::vector<T>& vec) : JVar(json::Type::array)
 	{
+		Array& array = AsArray();
 		for (const auto& i : vec)
-			m_raw.array->emplace_back(i);
+			array.emplace_back(i);
 	}
 
 	// shortcuts for As()
@@ -109,26 +134,25 @@ public :
 	long long Long() const			{return As<long long>();}
 	double Real() const				{return As<double>();}
 	bool Bool() const				{return As<bool>();}
-	const std::string& Str() const	{return As<std::string>();}
-	std::string& Str()				{return As<std::string>();}
-	const Array& AsArray() const	{return As<Array>();}
-	Array& AsArray()				{return As<Array>();}
-	const Hash& AsHash() const		{return As<Hash>();}
-	Hash& AsHash()					{return As<Hash>();}
+	StringView Str() const			{return As<std::string>();}
+	const Array& AsArray() const;
+	Array& AsArray();
+	const Hash& AsHash() const;
+	Hash& AsHash();
 	bool IsNull() const				{return Is<void>();}
 	std::size_t Size() const;
 
 	template <typename Visitor>
 	Visitor Apply(Visitor func) const
 	{
-		switch (m_type)
+		switch (Type())
 		{
-		case json::Type::integer:	func(*static_cast<const long long*>(&m_raw.integer));	break;
-		case json::Type::real:		func(*static_cast<const double*>(&m_raw.real));			break;
-		case json::Type::boolean:	func(*static_cast<const bool*>(&m_raw.boolean));		break;
-		case json::Type::string:	func(*static_cast<const std::string*>(m_raw.string));	break;
-		case json::Type::array:		func(*static_cast<const Array*>(m_raw.array));			break;
-		case json::Type::hash:		func(*static_cast<const Hash*>(m_raw.hash));			break;
+		case json::Type::integer:	func(static_cast<const long long&>(m_raw.word.integer));	break;
+		case json::Type::real:		func(static_cast<const double&>(m_raw.word.real));		break;
+		case json::Type::boolean:	func(static_cast<const bool&>(m_raw.word.boolean));		break;
+		case json::Type::string:	func(StringData());		break;
+		case json::Type::array:		func(AsArray());		break;
+		case json::Type::hash:		func(AsHash());			break;
 		default:	break;
 		}
 		return func;
@@ -136,26 +160,29 @@ public :
 	template <typename Visitor>
 	Visitor Apply(Visitor func)
 	{
-		switch (m_type)
+		switch (Type())
 		{
-		case json::Type::integer:	func(m_raw.integer);	break;
-		case json::Type::real:		func(m_raw.real);		break;
-		case json::Type::boolean:	func(m_raw.boolean);	break;
-		case json::Type::string:	func(*m_raw.string);	break;
-		case json::Type::array:		func(*m_raw.array);		break;
-		case json::Type::hash:		func(*m_raw.hash);		break;
+		case json::Type::integer:	func(m_raw.word.integer);	break;
+		case json::Type::real:		func(m_raw.word.real);		break;
+		case json::Type::boolean:	func(m_raw.word.boolean);	break;
+		case json::Type::string:	func(StringData());			break;
+		case json::Type::array:		func(AsArray());			break;
+		case json::Type::hash:		func(AsHash());				break;
 		default:	break;
 		}
 		return func;
 	}
 	
-	void Swap(JVar& rhs);
+	void Swap(JVar& rhs) noexcept;
+	
+	JVar& Share();
+	bool IsShared() const;
 	
 	// complex types only
 	template <typename T>
 	JVar& Add(T&& val)
 	{
-		if (m_type == json::Type::null)
+		if (Type() == json::Type::null)
 			*this = Array();
 
 		AsArray().emplace_back(std::forward<T>(val));
@@ -164,12 +191,11 @@ public :
 	template <typename T>
 	JVar& Add(const std::string& key, T&& val)
 	{
-		if (m_type == json::Type::null)
+		if (Type() == json::Type::null)
 			*this = Hash();
 		
-		AsHash().emplace(std::piecewise_construct,
-			std::forward_as_tuple(key),
-			std::forward_as_tuple(std::forward<T>(val)));
+		Hash& hash = AsHash();
+		hash.emplace(Hash::key_type(key.data(), key.size(), hash.get_allocator()), std::forward<T>(val));
 		return *this;
 	}
 	
@@ -179,8 +205,9 @@ public :
 	const JVar& operator[](std::size_t idx) const;
 	JVar& operator[](std::size_t idx);
 
+	// strings are returned by value as StringView
 	template <typename T, typename Out=typename TypeMap<T>::UnderlyingType>
-	const Out& As() const
+	typename std::enable_if<!std::is_same<Out, StringView>::value, const Out&>::type As() const
 	{
 		auto func = Apply(GetVal<const Out>{});
 		if (func.val == nullptr)
@@ -189,7 +216,7 @@ public :
 		return *func.val;
 	}
 	template <typename T, typename Out=typename TypeMap<T>::UnderlyingType>
-	Out& As()
+	typename std::enable_if<!std::is_same<Out, StringView>::value, Out&>::type As()
 	{
 		auto func = Apply(GetVal<Out>{});
 		if (func.val == nullptr)
@@ -197,13 +224,21 @@ public :
 		
 		return *func.val;
 	}
+	template <typename T, typename Out=typename TypeMap<T>::UnderlyingType>
+	typename std::enable_if<std::is_same<Out, StringView>::value, StringView>::type As() const
+	{
+		if (Type() != json::Type::string)
+			throw -1;
+		
+		return StringData();
+	}
 	template <typename T> bool Is() const
 	{
-		return m_type == TypeMap<T>::type;
+		return Type() == TypeMap<T>::type;
 	}
 	template <typename T> bool Equal(const T& v) const
 	{
-		auto func = Apply(CheckEqual<typename TypeMap<T>::UnderlyingType>(v));
+		auto func = Apply(CheckEqual<typename TypeMap<T>::UnderlyingType, T>(v));
 		return func.equal;
 	}
 
@@ -211,19 +246,76 @@ public :
 
 	json::Type Type() const;
 	bool Is(json::Type type) const;
+	Arena* GetArena() const;
 
 private :
+	template <typename T> struct Shared;
+	
+	StringView StringData() const;
+	
+	template <typename T>
+	static T& Unique(Shared<T> *&node);
+	template <typename T>
+	static void Release(Shared<T> *node);
+	
+private :
+	//! A string longer than small_string, allocated with its characters.
+	struct LongString
+	{
+		union
+		{
+			Arena						*arena;
+			std::atomic<std::size_t>	refs;	//!< for shared strings, which are on the heap
+		};
+		std::size_t	size;
+		char		data[1];
+	};
+	
+	static const std::uint8_t small_string	= 14;
+	static const std::uint8_t shared_string	= 0xFE;
+	static const std::uint8_t long_string	= 0xFF;
+	
+	static const std::uint8_t owned_node	= 1;
+	static const std::uint8_t shared_node	= 2;
+	
+	/*	All layouts start with the type, so it can be read from any of them.
+		
+		For strings, flag is the length of a small string, long_string or
+		shared_string. For arrays and hashes, it is owned_node or shared_node
+		if the container is allocated. Otherwise it is zero and the arena to
+		allocate the container from is stored instead.
+	*/
+	struct Word
+	{
+		json::Type		type;
+		std::uint8_t	flag;
+		union
+		{
+			long long	integer;
+			double		real;
+			bool		boolean;
+			LongString		*string;
+			Array			*array;
+			Hash			*hash;
+			Shared<Array>	*shared_array;
+			Shared<Hash>	*shared_hash;
+			Arena			*arena;
+		};
+	};
+	
+	struct Small
+	{
+		json::Type		type;
+		std::uint8_t	flag;
+		char			chars[small_string];
+	};
+	
 	union Raw
 	{
-		long long	integer;
-		double		real;
-		bool		boolean;
-		std::string	*string;
-		Array		*array;
-		Hash		*hash;
+		Word	word;
+		Small	small;
 	};
 
-	json::Type	m_type;
 	Raw 		m_raw;
 };
 
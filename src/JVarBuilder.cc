@@ -0,0 +1,154 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "JVarBuilder.hh"
+#include "SymbolTable.hh"
+
+#include <cassert>
+#include <cstring>
+#include <string>
+
+namespace json {
+
+namespace
+{
+	bool IsEscaped(const char *data, std::size_t len)
+	{
+		return data != nullptr && std::memchr(data, '\\', len) != nullptr;
+	}
+}
+
+JVarBuilder::JVarBuilder(Arena *arena, bool intern) :
+	m_arena(arena),
+	m_intern(intern)
+{
+}
+
+void JVarBuilder::Data(const Cursor& current, JSON_event type, const char *data, size_t len) const
+{
+	assert(this->Check(current));
+	*Child(current) = Scalar(type, data, len, m_arena);
+}
+
+Cursor JVarBuilder::Advance(const Cursor& current) const
+{
+	assert(this->Check(current));
+	return Cursor{current.Key(), Child(current), this};
+}
+
+void JVarBuilder::Start(const Cursor& current, JSON_event type) const
+{
+	assert(this->Check(current));
+	
+	auto target = current.Target<JVar>();
+	if (type == JSON_object_start)
+		*target = JVar(Type::hash, m_arena);
+	else if (type == JSON_array_start)
+		*target = JVar(Type::array, m_arena);
+}
+
+void JVarBuilder::Finish(const Cursor& current) const
+{
+	assert(this->Check(current));
+	
+	// sort the members appended by Child()
+	auto target = current.Target<JVar>();
+	if (target->Is(Type::hash))
+		target->AsHash().Seal();
+}
+
+void JVarBuilder::Write(const Cursor& current, Writer& out) const
+{
+	assert(this->Check(current));
+	out.Value(*current.Target<JVar>());
+}
+
+/**	Converts a string, number or literal to a JVar.
+*/
+JVar JVarBuilder::Scalar(JSON_event type, const char *data, std::size_t len, Arena *arena)
+{
+	switch (type)
+	{
+	case JSON_string:
+		if (IsEscaped(data, len))
+		{
+			std::string str = Unescape(data, len);
+			return JVar(str.data(), str.size(), arena);
+		}
+		return JVar(data, data ? len : 0, arena);
+	
+	case JSON_true:		return JVar(true);
+	case JSON_false:	return JVar(false);
+	
+	case JSON_number:
+		if (!std::memchr(data, '.', len) && !std::memchr(data, 'e', len) && !std::memchr(data, 'E', len))
+		{
+			try
+			{
+				return JVar(static_cast<long long>(LexicalCast<std::int64_t>(data, len)));
+			}
+			catch (OutOfRange&)
+			{
+			}
+		}
+		return JVar(LexicalCast<double>(data, len));
+	
+	default:	return JVar();
+	}
+}
+
+/**	Returns the value of the key of the Cursor in its target, which is a hash or
+	an array. The value is added as null if it is not there.
+*/
+JVar* JVarBuilder::Child(const Cursor& current) const
+{
+	auto parent = current.Target<JVar>();
+	const Key& key = current.Key();
+	
+	if (parent->Is(Type::array))
+	{
+		auto& array = parent->AsArray();
+		array.emplace_back();
+		return &array.back();
+	}
+	
+	// the last value wins for duplicated keys when the hash is sealed
+	if (!parent->Is(Type::hash))
+		*parent = JVar::Hash();
+	
+	auto& hash = parent->AsHash();
+	if (key.IsSymbol())
+		return &hash.Append(JVar::Hash::key_type(key, hash.get_allocator()));
+	
+	StringView name = key.Data();
+	std::string unescaped;
+	if (IsEscaped(name.data(), name.size()))
+	{
+		unescaped = Unescape(name.data(), name.size());
+		name = StringView{unescaped.data(), unescaped.data() + unescaped.size()};
+	}
+	
+	std::uint32_t id = m_intern ? SymbolTable::Global().Intern(name.data(), name.size()) : SymbolTable::npos;
+	return &hash.Append(id != SymbolTable::npos ?
+		JVar::Hash::key_type::Symbol(id, hash.get_allocator()) :
+		JVar::Hash::key_type(name, hash.get_allocator()));
+}
+
+} // end of namespace
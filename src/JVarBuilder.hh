@@ -0,0 +1,74 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef JVARBUILDER_HH_INCLUDED
+#define JVARBUILDER_HH_INCLUDED
+
+#include "TypeBuilder.hh"
+#include "JVar.hh"
+
+namespace json {
+
+/**	Builds a JVar from any JSON document.
+
+	JVarBuilder is used when the structure of the JSON is not known at compile time.
+	Objects become JVar::Hash and arrays become JVar::Array. The values are built
+	in place in their parents, and numbers are converted once to an integer, or to
+	a double if they have a fraction or exponent or do not fit in a long long.
+	Strings and keys are unescaped.
+	
+	If an Arena is given, all strings, arrays and hashes are allocated from it.
+	The target should then be the root of a Document that uses the same Arena.
+	
+	If intern is true, the keys of objects are interned in SymbolTable::Global()
+	so that documents with the same keys share them. Only use it when the keys
+	come from a bounded set.
+	
+	\code{.cpp}
+	JVarBuilder h;
+	JsonParser parser(&h);
+	JVar doc;
+	parser.Parse(json, len, &doc);
+	\endcode
+*/
+class JVarBuilder : public TypeBuilder<JVar>
+{
+public:
+	explicit JVarBuilder(Arena *arena = nullptr, bool intern = false);
+	
+	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override;
+	Cursor Advance(const Cursor& current) const override;
+	void Start(const Cursor& current, JSON_event type) const override;
+	void Finish(const Cursor& current) const override;
+	void Write(const Cursor& current, Writer& out) const override;
+	
+	static JVar Scalar(JSON_event type, const char *data, std::size_t len, Arena *arena = nullptr);
+	
+private:
+	JVar* Child(const Cursor& current) const;
+
+private:
+	Arena	*m_arena;
+	bool	m_intern;
+};
+
+} // end of namespace
+
+#endif
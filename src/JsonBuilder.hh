@@ -22,14 +22,45 @@
 #define JSONBUILDER_HH_INCLUDED
 
 #include "TypeBuilder.hh"
+#include "KeyTable.hh"
 
+#include <algorithm>
 #include <initializer_list>
-#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace json {
 
-/**	Brief description of JsonBuilder
+template <typename Host>
+class JsonBuilder;
+
+namespace detail
+{
+	template <typename Builder>
+	void CompileKeys(Builder&)
+	{
+	}
+	
+	template <typename T>
+	void CompileKeys(JsonBuilder<T>& builder)
+	{
+		builder.Compile();
+	}
+}
+
+/**	Builds an object of type Host from a JSON object by mapping its keys to members.
+
+	The members are added by Add() or the constructors. Compile() freezes the
+	keys into a perfect hash table (see KeyTable), so looking up the member of a
+	key during parsing takes constant time. The constructors compile the keys
+	once after adding all their members. After adding members by Add(), call
+	Compile() before parsing. Until then the keys are looked up by linear
+	search.
+	
+	The keys are compared with the escaped text of the JSON, so a key with
+	special characters is given in its escaped form, e.g. "a\\\"b" for the
+	JSON key "a\"b".
 */
 template <typename Host>
 class JsonBuilder : public TypeBuilder<Host>
@@ -46,20 +77,24 @@ public :
 	JsonBuilder(const Key& key, T Host::*mem)
 	{
 		Add(key, mem);
+		Compile();
 	}
 	
 	template <typename T, class V=JsonBuilder<T> >
 	JsonBuilder(const Key& key, T Host::*mem, const V& rec)
 	{
 		Add(key, mem, rec);
+		Compile();
 	}
 	
 	JsonBuilder(std::initializer_list<JsonBuilder> l)
 	{
 		for (const auto& i : l)
 		{
-			m_obj_act.insert(i.m_obj_act.begin(), i.m_obj_act.end());
+			for (std::size_t id = 0 ; id < i.m_keys.Size() ; ++id)
+				Insert(i.m_keys.At(id), i.m_obj_act[id]);
 		}
+		Compile();
 	}
 
 	template <typename T>
@@ -77,38 +112,118 @@ public :
 		static_assert(
 			std::is_base_of<TypeBuilder<T>, Builder>::value,
 			"member type and visitor does not match");
-		m_obj_act.emplace(key, std::make_shared<MemberBuilder<Host,T,Builder>>(rec, mem));
+		
+		// the copy of a nested JsonBuilder cannot be compiled by the caller
+		Builder nested(rec);
+		detail::CompileKeys(nested);
+		Insert(key, std::make_shared<MemberBuilder<Host,T,Builder>>(nested, mem));
+	}
+	
+	void Compile()
+	{
+		m_keys.Compile();
+	}
+	
+	bool IsCompiled() const
+	{
+		return m_keys.IsCompiled();
 	}
 	
 	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override
 	{
 		assert(this->Check(current));
 
-		auto i = m_obj_act.find(current.Key());
-		if (i != m_obj_act.end())
-			i->second->Data(current.Forward(i->second.get()), type, data, len);
+		auto mem = Find(current);
+		if (mem)
+			mem->Data(current.Forward(mem), type, data, len);
 	}
 	
 	Cursor Advance(const Cursor& current) const override
 	{
 		assert(this->Check(current));		
 		
-		Cursor mock{current.Key()};
-
-		auto i = m_obj_act.find(current.Key());
-		return i != m_obj_act.end() ?
-			i->second->Advance(current.Forward(i->second.get())) : mock ;
+		auto mem = Find(current);
+		return mem ? mem->Advance(current.Forward(mem)) : Cursor{current.Key()} ;
 	}
 
 	void Finish(const Cursor& current) const override
 	{
 		assert(this->Check(current));
 	}
+	
+	void Write(const Cursor& current, Writer& out) const override
+	{
+		assert(this->Check(current));
+		
+		if (m_array && !m_obj_act.empty())
+			return WriteArray(current, out);
+		
+		out.Raw('{');
+		for (std::size_t id = 0 ; id < m_obj_act.size() ; ++id)
+		{
+			// skip the comma before the first member
+			const std::string& name = m_names[id];
+			out.Raw(name.data() + (id == 0), name.size() - (id == 0));
+			m_obj_act[id]->Write(current.Forward(m_obj_act[id].get()), out);
+		}
+		out.Raw('}');
+	}
 
 private:
 	using MemBase	= TypeBuilder<Host>;
-	using ObjMap	= std::map<Key, std::shared_ptr<const MemBase>> ;
-	ObjMap	m_obj_act;
+	using ObjMap	= std::vector<std::shared_ptr<const MemBase>>;	// indexed by key ID
+	
+	void Insert(const Key& key, const std::shared_ptr<const MemBase>& mem)
+	{
+		// the first member with the same key wins, just like std::map::insert()
+		if (m_keys.Add(key) == m_obj_act.size())
+		{
+			m_obj_act.push_back(mem);
+			
+			// the comma, the quoted key and the colon. The key is matched
+			// against the escaped text of the JSON, so it is already escaped.
+			std::string name = ",\"" + key.Str() + "\":";
+			m_names.push_back(std::move(name));
+			
+			m_array = m_array && key.IsIndex();
+		}
+	}
+	
+	// the elements missing in the builder are written as null
+	void WriteArray(const Cursor& current, Writer& out) const
+	{
+		std::size_t size = 0;
+		for (std::size_t id = 0 ; id < m_keys.Size() ; ++id)
+			size = std::max(size, m_keys.At(id).Index() + 1);
+		
+		out.Raw('[');
+		for (std::size_t idx = 0 ; idx < size ; ++idx)
+		{
+			if (idx > 0)
+				out.Raw(',');
+			
+			std::size_t id = m_keys.Find(Key{idx});
+			if (id != KeyTable::npos)
+				m_obj_act[id]->Write(current.Forward(m_obj_act[id].get()), out);
+			else
+				out.Null();
+		}
+		out.Raw(']');
+	}
+	
+	const MemBase* Find(const Cursor& current) const
+	{
+		auto predict = current.Predictor();
+		auto id = predict ? predict->Find(m_keys, current.Key()) : m_keys.Find(current.Key());
+		return id != KeyTable::npos ? m_obj_act[id].get() : nullptr;
+	}
+	
+private:
+	KeyTable	m_keys;
+	ObjMap		m_obj_act;
+	
+	std::vector<std::string>	m_names;		//!< written before each member, indexed by key ID
+	bool						m_array{true};	//!< all keys are indexes
 };
 
 } // end of namespace
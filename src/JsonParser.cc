@@ -19,6 +19,7 @@
 */
 
 #include "JsonParser.hh"
+#include "MappedFile.hh"
 
 #include <cassert>
 #include <iostream>
@@ -27,27 +28,100 @@ namespace json {
 
 JsonParser::JsonParser(const JsonProcessor *root, std::size_t depth) :
 	m_json(::new_JSON_checker(static_cast<int>(depth))),
+	m_depth(depth),
 	m_key(0),
-	m_root(root)
+	m_root(root),
+	m_stack_keys(depth),
+	m_predict(depth)
 {
 	m_root.SetKey(m_key);
 	assert(m_root.Key());
+	
+	m_stack.reserve(depth);
 }
 
 JsonParser::~JsonParser()
 {
+	::JSON_checker_done(m_json);
 }
 
-void JsonParser::Done()
+/**	Ends the JSON document and resets the parser for the next one.
+
+	\return	false if the document is incomplete, e.g. the text ends in the
+				middle of an object.
+*/
+bool JsonParser::Done()
 {
-	::JSON_checker_done(m_json);
-	m_json = ::new_JSON_checker(5);
+	bool accepted = ::JSON_checker_done(m_json) != 0;
+	Restart();
+	return accepted;
+}
+
+/**	Replaces the checker, which JSON_checker_done() deletes, and drops the
+	objects and arrays left unfinished by an incomplete document.
+*/
+void JsonParser::Restart()
+{
+	m_json = ::new_JSON_checker(static_cast<int>(m_depth));
+	m_stack.clear();
+	m_key.SetIndex(0);
 }
 
 void JsonParser::Parse(const char *data, size_t len)
 {
 	assert(m_root);
 	if (::JSON_checker_char(m_json, data, len, &JsonParser::Callback, this) == JSON_error)
+	{
+		// the checker deletes itself when it rejects the text
+		Restart();
+		throw ParseError() << LineNumInfo(0) << ColumnNumInfo(0) ;
+	}
+	
+	SaveKeys();
+}
+
+/**	Copies the keys that refer to the input buffer, which may be gone when the
+	next chunk comes.
+	
+	They are the key of the current member if its value is yet to be parsed,
+	and the keys of the objects and arrays that are not finished, which are
+	given to Finish() at their end.
+*/
+void JsonParser::SaveKeys()
+{
+	if (m_key.IsKey() && m_key.Data().begin() != m_key_buf.data())
+	{
+		m_key_buf.assign(m_key.Data().begin(), m_key.Data().end());
+		m_key.SetKey(m_key_buf);
+	}
+	
+	assert(m_stack.size() <= m_stack_keys.size());
+	for (std::size_t i = 0 ; i < m_stack.size() ; ++i)
+	{
+		Key key = m_stack[i].Key();
+		std::string& buf = m_stack_keys[i];
+		if (key.IsKey() && key.Data().begin() != buf.data())
+		{
+			buf.assign(key.Data().begin(), key.Data().end());
+			m_stack[i].SetKey(Key{buf});
+		}
+	}
+}
+
+/**	Parses a JSON document in a file.
+
+	The file is memory-mapped and parsed in one call, so it is neither read
+	in chunks nor copied. The parser is reset by Done() afterwards and is ready
+	for the next document. StringView members built from the file refer to
+	the mapping, which is gone when this function returns.
+	
+	\throw	ParseError	If the file ends before the document does.
+*/
+void JsonParser::ParseFile(const std::string& path)
+{
+	MappedFile file(path);
+	Parse(file.Data(), file.Size());
+	if (!Done())
 		throw ParseError() << LineNumInfo(0) << ColumnNumInfo(0) ;
 }
 
@@ -72,11 +146,15 @@ void JsonParser::Callback(JSON_event type, const char *data, size_t len)
 	{
 		case JSON_object_key:
 			assert(!m_key);
-			m_key.SetKey(std::string(data, len));
+			m_key.SetKey(data, len);
 			break;
 		
 		case JSON_object_start:
 		case JSON_array_start:
+			// the JSON_checker rejects nesting deeper than m_depth, so the
+			// stack never grows beyond its capacity
+			assert(m_stack.size() < m_stack.capacity());
+			
 			// first call
 			if (m_stack.empty())
 				m_stack.push_back(m_root);
@@ -84,6 +162,11 @@ void JsonParser::Callback(JSON_event type, const char *data, size_t len)
 				m_stack.push_back(m_stack.back().Rec()->Advance(Next()));
 			
 			assert(m_stack.back().Key());
+			m_stack.back().Rec()->Start(m_stack.back(), type);
+			
+			assert(m_stack.size() <= m_predict.size());
+			m_predict[m_stack.size()-1].Restart();
+			m_stack.back().SetPredictor(&m_predict[m_stack.size()-1]);
 			
 			m_key.Clear();
 			if (type == JSON_array_start)
@@ -92,14 +175,21 @@ void JsonParser::Callback(JSON_event type, const char *data, size_t len)
 		
 		case JSON_object_end:
 		case JSON_array_end:
+		{
 			assert(!m_stack.empty());
 			assert(m_stack.back().Key());
 			
+			// arrays are finished with the number of elements as the key
+			Cursor done = m_stack.back();
+			if (type == JSON_array_end)
+				done.SetKey(m_key);
+			
 			m_key = m_stack.back().Key();
-			m_stack.back().Rec()->Finish(m_stack.back());
+			done.Rec()->Finish(done);
 			m_stack.pop_back();
 			FinishKey();
 			break;
+		}
 			
 		case JSON_string:
 		case JSON_number:
@@ -24,6 +24,7 @@
 
 #include "JSON_checker.h"
 #include "TypeBuilder.hh"
+#include "KeyTable.hh"
 
 #include "Exception.hh"
 
@@ -34,7 +35,11 @@ namespace json {
 
 class Reactor;
 	
-/**	Brief description of JsonParser
+/**	Parses JSON and builds C++ objects by the JsonProcessor given.
+
+	The \c depth argument limits the level of nesting of the JSON. The parser
+	allocates its stack for that many levels when it is constructed, so no
+	memory is allocated when parsing nested objects.
 */
 class JsonParser
 {
@@ -59,24 +64,42 @@ public :
 		Parse(data, len);
 	}
 	
+	template <typename Target>
+	void ParseFile(const std::string& path, Target *target)
+	{
+		SetTarget(target);
+		ParseFile(path);
+	}
+	
 	void Parse(const char *data, size_t len);
-	void Done();
+	void ParseFile(const std::string& path);
+	bool Done();
 	
 private:
 	static void Callback(void *pvthis, JSON_event type, const char *data, size_t len);
 	void Callback(JSON_event type, const char *data, size_t len);
 
 	void FinishKey();
+	void SaveKeys();
+	void Restart();
 	Cursor Next() const ;
 	
 private :
 	// underlying parser
 	JSON_checker 		m_json;
+	const std::size_t	m_depth;
 	
 	// states
 	Key					m_key;
+	std::string			m_key_buf;	//!< saves m_key across Parse() calls
 	Cursor				m_root;
-	std::vector<Cursor>	m_stack;
+	std::vector<Cursor>	m_stack;	//!< capacity fixed to m_depth
+	
+	//! saves the keys of the Cursors in m_stack across Parse() calls
+	std::vector<std::string>	m_stack_keys;
+	
+	// key predictors for each level of m_stack
+	std::vector<KeyPredictor>	m_predict;
 };
 
 } // end of namespace
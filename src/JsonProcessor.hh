@@ -26,6 +26,7 @@
 namespace json {
 
 class Cursor;
+class Writer;
 
 /**	The abstract class for handle JSON data
 
@@ -35,6 +36,19 @@ class Cursor;
 	
 	Derived classes are supposed to implement their own processing. For example, the
 	JsonBuilder classes save the parsed data into a mapped object.
+	
+	Start() is called when the object or array of a Cursor begins, right after the
+	Cursor is returned by Advance() of the parent. Most builders only need the
+	type of the target and ignore it.
+	
+	Finish() is called at the end of an object or array. For objects, the key of
+	the Cursor is the key of the object in its parent. For arrays, it is an index
+	equal to the number of elements in the array.
+	
+	Write() does the reverse: it writes the target of the Cursor as JSON with
+	the same mapping that builds it, so the same schema serves both ways. The
+	target is not modified. Processors that cannot write their targets write
+	null.
 */
 class JsonProcessor
 {
@@ -42,7 +56,9 @@ public:
 	virtual ~JsonProcessor() = default;
 	virtual void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const = 0;
 	virtual Cursor Advance(const Cursor& current) const = 0;
+	virtual void Start(const Cursor&, JSON_event) const {}
 	virtual void Finish(const Cursor& current) const = 0;
+	virtual void Write(const Cursor& current, Writer& out) const;
 };
 
 } // end of namespace
@@ -19,40 +19,102 @@
 */
 
 #include "Key.hh"
+#include "SymbolTable.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
 
 namespace json {
 
-Key::Key() : m_type(none)
+static_assert(std::is_trivially_copyable<Key>::value, "Key should be trivially copyable");
+static_assert(sizeof(Key) == 2 * sizeof(void*), "Key should take two words");
+
+Key::Key() : m_str(nullptr), m_type(none), m_val(0)
 {
 	assert(!*this);
 }
 
-Key::Key(const std::string& k) : m_type(key), m_key(k)
+Key::Key(const std::string& k) : m_str(k.data()), m_type(key), m_val(k.size())
+{
+	assert(*this);
+}
+
+Key::Key(const char *str, std::size_t len) : m_str(str), m_type(key), m_val(len)
 {
 	assert(*this);
 }
 
-Key::Key(std::size_t idx) : m_type(index), m_index(idx)
+Key::Key(std::size_t idx) : m_str(nullptr), m_type(index), m_val(idx)
 {
 	assert(*this);
 }
 	
+/**	Creates a key of a symbol in SymbolTable::Global().
+*/
+Key Key::Symbol(std::uint32_t id)
+{
+	Key k;
+	k.m_type = symbol;
+	k.m_val  = id;
+	return k;
+}
+
+/**	Interns the key string in SymbolTable::Global().
+
+	\return	A symbol of the key string, or a copy of the Key if it is not a
+			key string or the table is full.
+*/
+Key Key::Intern() const
+{
+	if (m_type != key)
+		return *this;
+	
+	std::uint32_t id = SymbolTable::Global().Intern(m_str, m_val);
+	return id != SymbolTable::npos ? Symbol(id) : *this;
+}
+
 std::size_t Key::Index() const
 {
-	return m_index;
+	assert(m_type == index);
+	return m_val;
 }
 
+std::uint32_t Key::SymbolId() const
+{
+	assert(m_type == symbol);
+	return static_cast<std::uint32_t>(m_val);
+}
+
+/**	Returns a copy of the key string.
+
+	It allocates memory for the string. Use Data() if you only need to look at
+	the content of the key.
+*/
 std::string Key::Str() const
 {
-	return m_key;
+	auto str = Data();
+	return std::string(str.begin(), str.end());
+}
+
+/**	Returns the key string without copying it.
+
+	The returned range is only valid as long as the string that the Key refers to.
+*/
+Key::View Key::Data() const
+{
+	if (m_type == symbol)
+		return SymbolTable::Global().Name(SymbolId());
+	
+	return m_type == key ? View{m_str, m_str + m_val} : View{m_str, m_str};
 }
 
 void Key::AdvanceIndex()
 {
 	assert(m_type == index);
-	m_index++;
+	m_val++;
 }
 
 bool Key::IsIndex() const
@@ -62,7 +124,12 @@ bool Key::IsIndex() const
 
 bool Key::IsKey() const
 {
-	return m_type == key;
+	return m_type == key || m_type == symbol;
+}
+
+bool Key::IsSymbol() const
+{
+	return m_type == symbol;
 }
 
 Key::operator bool() const
@@ -73,13 +140,20 @@ Key::operator bool() const
 void Key::SetIndex(std::size_t idx)
 {
 	m_type  = index;
-	m_index = idx;
+	m_str   = nullptr;
+	m_val = idx;
 }
 
 void Key::SetKey(const std::string& k)
+{
+	SetKey(k.data(), k.size());
+}
+
+void Key::SetKey(const char *str, std::size_t len)
 {
 	m_type = key;
-	m_key  = k;
+	m_str  = str;
+	m_val  = len;
 }
 
 void Key::Clear()
@@ -87,14 +161,47 @@ void Key::Clear()
 	m_type = none;
 }
 
+bool Key::SameString(const Key& k) const
+{
+	auto s1 = Data(), s2 = k.Data();
+	return s1.size() == s2.size() && (s1.size() == 0 || std::memcmp(s1.begin(), s2.begin(), s1.size()) == 0);
+}
+
+bool Key::operator==(const Key& k) const
+{
+	if (m_type == symbol && k.m_type == symbol)
+		return m_val == k.m_val;
+	else if (IsKey() && k.IsKey())
+		return SameString(k);
+	else if (m_type != k.m_type)
+		return false;
+	else if (m_type == index)
+		return m_val == k.m_val;
+	else
+		return true;
+}
+
+bool Key::operator!=(const Key& k) const
+{
+	return !(*this == k);
+}
+
 bool Key::operator<(const Key& k) const
 {
-	if (m_type != k.m_type)
-		return m_type < k.m_type;
-	else if (m_type == key)
-		return m_key < k.m_key;
+	if (IsKey() && k.IsKey())
+	{
+		// same ordering as std::string
+		auto s1 = Data(), s2 = k.Data();
+		std::size_t n = std::min(s1.size(), s2.size());
+		int r = n > 0 ? std::memcmp(s1.begin(), s2.begin(), n) : 0;
+		return r < 0 || (r == 0 && s1.size() < s2.size());
+	}
+	else if (m_type != k.m_type)
+		return (IsKey() ? key : static_cast<Type>(m_type)) < (k.IsKey() ? key : static_cast<Type>(k.m_type));
+	else if (m_type == index)
+		return m_val < k.m_val;
 	else
-		return m_index < k.m_index;
+		return false;
 }
 
 std::ostream& operator<<(std::ostream& os, const Key& key)
@@ -102,7 +209,7 @@ std::ostream& operator<<(std::ostream& os, const Key& key)
 	if (key.IsIndex())
 		os << key.Index();
 	else
-		os << key.Str();
+		os.write(key.Data().begin(), key.Data().size());
 	return os;
 }
 
@@ -21,43 +21,82 @@
 #ifndef KEY_HH_INCLUDED
 #define KEY_HH_INCLUDED
 
+#include "Range.hh"
+
+#include <climits>
+#include <cstdint>
 #include <string>
 #include <iosfwd>
 
 namespace json {
 
-/**	Brief description of Key
+/**	The key of a member inside a JSON object, or the index of an element in an array.
+
+	A Key does not own the string it refers to. It is merely a view to a string
+	that is stored somewhere else, e.g. the input buffer of the JsonParser or
+	the string literal used to set up a JsonBuilder. Therefore copying a Key
+	never allocates memory, but the caller must make sure the string outlives
+	the Key.
+	
+	A key string can also be a symbol interned in SymbolTable::Global(). Symbols
+	refer to the strings stored in the table, and comparing two symbols only
+	compares their IDs. Symbols are keys, so IsKey() and Data() work the same
+	for them.
+	
+	Key is trivially copyable and takes two words.
 */
 class Key
 {
+public:
+	using View = Range<const char*>;
+
 public:
 	Key() ;
 	
 	template <std::size_t n>
-	Key(const char (&str)[n]) : m_type(key), m_index(0), m_key(str) {}
+	Key(const char (&str)[n]) : m_str(str), m_type(key), m_val(std::char_traits<char>::length(str)) {}
 	
 	Key(const std::string& k);
+	Key(std::string&&) = delete;	// the key would refer to a temporary
+	Key(const char *str, std::size_t len);
 	Key(std::size_t idx);
 	
+	static Key Symbol(std::uint32_t id);
+	Key Intern() const;
+	
 	std::size_t Index() const;
+	std::uint32_t SymbolId() const;
 	std::string Str() const;
+	View Data() const;
 
 	bool IsIndex() const;
 	bool IsKey() const;
+	bool IsSymbol() const;
 	explicit operator bool() const;
 
 	void SetIndex(std::size_t idx);
 	void AdvanceIndex();
 	void SetKey(const std::string& k);
+	void SetKey(std::string&&) = delete;
+	void SetKey(const char *str, std::size_t len);
 	void Clear();
 
-	// for std::map
+	bool operator==(const Key& k) const;
+	bool operator!=(const Key& k) const;
 	bool operator<(const Key& k) const;
 
 private:
-	enum Type {none, key, index} m_type;
-	std::string m_key;
-	std::size_t m_index;
+	enum Type {none, key, index, symbol};
+	
+	bool SameString(const Key& k) const;
+	
+	// packed into two words so that Keys and Cursors are cheap to copy
+	static const unsigned type_bits = 2;
+	static const unsigned val_bits  = sizeof(std::size_t) * CHAR_BIT - type_bits;
+	
+	const char	*m_str;					//!< the key string, or null for symbols
+	std::size_t	m_type : type_bits;		//!< Type of the key
+	std::size_t	m_val  : val_bits;		//!< length of the key string, array index or symbol ID
 };
 
 std::ostream& operator<<(std::ostream& os, const Key& key);
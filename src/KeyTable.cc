@@ -0,0 +1,295 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "KeyTable.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace json {
+
+namespace
+{
+	const std::uint32_t empty_slot = static_cast<std::uint32_t>(-1);
+	const std::uint64_t golden     = 0x9E3779B97F4A7C15ULL;
+
+	// finalizer of MurmurHash3
+	std::uint64_t Mix(std::uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	std::size_t NextPow2(std::size_t n)
+	{
+		std::size_t r = 1;
+		while (r < n)
+			r <<= 1;
+		return r;
+	}
+}
+
+const std::size_t KeyTable::npos;
+
+KeyTable::KeyTable() : m_seed(0), m_compiled(false)
+{
+}
+
+Key KeyTable::Entry::ToKey() const
+{
+	return is_index ? Key{index} : Key{name};
+}
+
+/**	Adds a key to the table.
+
+	The table needs to be compiled again after adding keys. Before that, Find()
+	falls back to linear search.
+
+	\return	The ID of the key. If the key is already in the table, the ID of the
+			existing key will be returned.
+*/
+std::size_t KeyTable::Add(const Key& key)
+{
+	assert(key);
+
+	std::size_t id = LinearFind(key);
+	if (id == npos)
+	{
+		id = m_keys.size();
+		m_keys.push_back(Entry{key.Str(), key.IsIndex() ? key.Index() : 0, key.IsIndex()});
+
+		m_compiled = false;
+		m_disp.clear();
+		m_slots.clear();
+	}
+	return id;
+}
+
+/**	Builds the perfect hash table for the keys added.
+
+	The table has at least twice as many slots as there are keys. If no
+	displacement can be found for a bucket, another seed will be tried, and
+	the table will grow if a few seeds still do not work.
+*/
+void KeyTable::Compile()
+{
+	if (m_compiled)
+		return;
+
+	for (std::size_t size = NextPow2(std::max<std::size_t>(2, m_keys.size() * 2)) ; !m_compiled ; size *= 2)
+	{
+		assert(size < empty_slot);
+		for (std::uint64_t seed = 0 ; seed < 8 && !m_compiled ; ++seed)
+			m_compiled = TryCompile(seed * golden, size);
+	}
+}
+
+bool KeyTable::TryCompile(std::uint64_t seed, std::size_t table_size)
+{
+	using Hashed = std::pair<std::uint64_t, std::uint32_t>;	// hash and ID
+
+	const std::size_t bucket_count = std::max<std::size_t>(1, table_size / 4);
+	const std::size_t mask         = table_size - 1;
+
+	std::vector<std::vector<Hashed>> buckets(bucket_count);
+	for (std::size_t id = 0 ; id < m_keys.size() ; ++id)
+	{
+		std::uint64_t h = Hash(m_keys[id].ToKey(), seed);
+		buckets[(h >> 32) & (bucket_count-1)].emplace_back(h, static_cast<std::uint32_t>(id));
+	}
+
+	// place the largest buckets first when the table is still empty
+	std::vector<std::size_t> order(bucket_count);
+	for (std::size_t b = 0 ; b < bucket_count ; ++b)
+		order[b] = b;
+	std::stable_sort(order.begin(), order.end(), [&buckets](std::size_t b1, std::size_t b2)
+	{
+		return buckets[b1].size() > buckets[b2].size();
+	});
+
+	std::vector<std::uint32_t> slots(table_size, empty_slot);
+	std::vector<std::uint32_t> disp(bucket_count, 0);
+
+	for (std::size_t b : order)
+	{
+		const auto& bucket = buckets[b];
+		if (bucket.empty())
+			break;
+
+		// the same displacement is applied to all keys in the bucket, so they
+		// will collide for all displacements if they share the same slot
+		for (std::size_t i = 0 ; i < bucket.size() ; ++i)
+			for (std::size_t j = i+1 ; j < bucket.size() ; ++j)
+				if ((bucket[i].first & mask) == (bucket[j].first & mask))
+					return false;
+
+		bool placed = false;
+		for (std::uint32_t d = 0 ; d < table_size && !placed ; ++d)
+		{
+			placed = std::all_of(bucket.begin(), bucket.end(), [&slots, d, mask](const Hashed& h)
+			{
+				return slots[(h.first ^ d) & mask] == empty_slot;
+			});
+
+			if (placed)
+			{
+				for (const auto& h : bucket)
+					slots[(h.first ^ d) & mask] = h.second;
+				disp[b] = d;
+			}
+		}
+
+		if (!placed)
+			return false;
+	}
+
+	m_seed = seed;
+	m_disp.swap(disp);
+	m_slots.swap(slots);
+	return true;
+}
+
+/**	Looks up a key.
+
+	\return	The ID of the key, or npos if the key is not in the table.
+*/
+std::size_t KeyTable::Find(const Key& key) const
+{
+	if (!m_compiled)
+		return LinearFind(key);
+
+	if (m_keys.empty())
+		return npos;
+
+	std::uint64_t h  = Hash(key, m_seed);
+	std::uint32_t d  = m_disp[(h >> 32) & (m_disp.size()-1)];
+	std::uint32_t id = m_slots[(h ^ d) & (m_slots.size()-1)];
+
+	return id != empty_slot && m_keys[id].ToKey() == key ? id : npos;
+}
+
+std::size_t KeyTable::LinearFind(const Key& key) const
+{
+	for (std::size_t id = 0 ; id < m_keys.size() ; ++id)
+		if (m_keys[id].ToKey() == key)
+			return id;
+	return npos;
+}
+
+Key KeyTable::At(std::size_t id) const
+{
+	assert(id < m_keys.size());
+	return m_keys[id].ToKey();
+}
+
+std::size_t KeyTable::Size() const
+{
+	return m_keys.size();
+}
+
+bool KeyTable::IsCompiled() const
+{
+	return m_compiled;
+}
+
+/**	Hashes a key with a seed.
+*/
+std::uint64_t KeyTable::Hash(const Key& key, std::uint64_t seed)
+{
+	if (key.IsIndex())
+		return Mix(seed ^ ~(key.Index() * golden));
+
+	auto str = key.Data();
+	return Hash(str.begin(), str.size(), seed);
+}
+
+/**	Hashes a string with a seed.
+
+	Strings are read 8 bytes at a time, which is fast enough for the short
+	keys usually found in JSON.
+*/
+std::uint64_t KeyTable::Hash(const char *p, std::size_t len, std::uint64_t seed)
+{
+	std::uint64_t h = seed ^ (len * golden);
+	for ( ; len >= sizeof(h) ; len -= sizeof(h), p += sizeof(h))
+	{
+		std::uint64_t w;
+		std::memcpy(&w, p, sizeof(w));
+		h = (h ^ w) * golden;
+		h ^= h >> 29;
+	}
+	if (len > 0)
+	{
+		std::uint64_t w = 0;
+		std::memcpy(&w, p, len);
+		h = (h ^ w) * golden;
+	}
+	return Mix(h);
+}
+
+KeyPredictor::KeyPredictor() : m_table(nullptr), m_last(0)
+{
+}
+
+/**	Looks up a key in a KeyTable, trying the predicted key first.
+
+	\return	The ID of the key, or KeyTable::npos if the key is not in the table.
+*/
+std::size_t KeyPredictor::Find(const KeyTable& table, const Key& key)
+{
+	// learn again when used with another table
+	if (m_table != &table || m_next.size() != table.Size() + 1)
+	{
+		m_table = &table;
+		m_next.assign(table.Size() + 1, KeyTable::npos);
+		m_last = table.Size();
+	}
+
+	assert(m_last < m_next.size());
+	std::size_t& guess = m_next[m_last];
+
+	std::size_t id = guess;
+	if (id == KeyTable::npos || table.At(id) != key)
+	{
+		id = table.Find(key);
+		if (id != KeyTable::npos)
+			guess = id;
+	}
+
+	if (id != KeyTable::npos)
+		m_last = id;
+	return id;
+}
+
+/**	Tells the predictor that a new object begins.
+*/
+void KeyPredictor::Restart()
+{
+	if (m_table)
+		m_last = m_table->Size();
+}
+
+} // end of namespace
@@ -0,0 +1,115 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef KEYTABLE_HH_INCLUDED
+#define KEYTABLE_HH_INCLUDED
+
+#include "Key.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace json {
+
+/**	A fixed set of keys that can be looked up in constant time.
+
+	KeyTable assigns an ID to each key added to it. The IDs start from zero and
+	follow the order of insertion. After all keys are added, call Compile() to
+	build a perfect hash table for the keys. Looking up a key in a compiled
+	table takes one hash calculation and at most one key comparison.
+
+	The table uses "hash and displace": the keys are first hashed into buckets,
+	and each bucket is given a displacement that moves all of its keys to
+	empty slots of the table. The displacements are found by Compile().
+
+	Find() is a const function without side effects, so a compiled table can be
+	shared by many threads.
+*/
+class KeyTable
+{
+public:
+	static const std::size_t npos = static_cast<std::size_t>(-1);
+
+public:
+	KeyTable();
+
+	std::size_t Add(const Key& key);
+	void Compile();
+
+	std::size_t Find(const Key& key) const;
+	Key At(std::size_t id) const;
+
+	std::size_t Size() const;
+	bool IsCompiled() const;
+
+	static std::uint64_t Hash(const Key& key, std::uint64_t seed);
+	static std::uint64_t Hash(const char *str, std::size_t len, std::uint64_t seed);
+
+private:
+	struct Entry
+	{
+		std::string		name;
+		std::size_t		index;
+		bool			is_index;
+
+		Key ToKey() const;
+	};
+
+	std::size_t LinearFind(const Key& key) const;
+	bool TryCompile(std::uint64_t seed, std::size_t table_size);
+
+private:
+	std::vector<Entry>			m_keys;
+
+	// the compiled perfect hash
+	std::vector<std::uint32_t>	m_disp;		//!< displacement of each bucket
+	std::vector<std::uint32_t>	m_slots;	//!< IDs of the keys, or empty
+	std::uint64_t				m_seed;
+	bool						m_compiled;
+};
+
+/**	Predicts the next key to be looked up in a KeyTable.
+
+	JSON producers usually emit the keys of an object in the same order every
+	time. KeyPredictor remembers which key was found after the previous one, and
+	tries it first with a single comparison before looking up the KeyTable.
+
+	The predictor stores the state of a parse, so it is not shared between
+	threads. JsonParser keeps one for each level of nesting.
+*/
+class KeyPredictor
+{
+public:
+	KeyPredictor();
+
+	std::size_t Find(const KeyTable& table, const Key& key);
+	void Restart();
+
+private:
+	const KeyTable				*m_table;
+	std::size_t					m_last;	//!< ID of the last key found, or Size() at the start of an object
+	std::vector<std::size_t>	m_next;	//!< m_next[id] is the ID of the key found after id last time
+};
+
+} // end of namespace
+
+#endif
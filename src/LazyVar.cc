@@ -0,0 +1,425 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "LazyVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
+#include "Exception.hh"
+#include "LexicalCast.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace json {
+
+namespace
+{
+	bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+	
+	const char* SkipSpace(const char *p, const char *end)
+	{
+		while (p != end && IsSpace(*p))
+			++p;
+		return p;
+	}
+	
+	/*	Returns the end of the string that starts at p, or null if the string
+		is not terminated.
+	*/
+	const char* SkipString(const char *p, const char *end)
+	{
+		assert(*p == '"');
+		
+		for (const char *q = p + 1 ; ; ++q)
+		{
+			q = static_cast<const char*>(std::memchr(q, '"', static_cast<std::size_t>(end - q)));
+			if (!q)
+				return nullptr;
+			
+			// the quote is escaped if there is an odd number of backslashes
+			// before it. The opening quote stops the count.
+			const char *b = q;
+			while (b[-1] == '\\')
+				--b;
+			if ((q - b) % 2 == 0)
+				return q + 1;
+		}
+	}
+	
+	bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+	
+	/*	Returns the end of the number that starts at p, or null if it is not a
+		valid JSON number.
+	*/
+	const char* SkipNumber(const char *p, const char *end)
+	{
+		if (p != end && *p == '-')
+			++p;
+		
+		// integer part: no leading zero
+		if (p == end || !IsDigit(*p))
+			return nullptr;
+		if (*p++ != '0')
+			while (p != end && IsDigit(*p))
+				++p;
+		
+		if (p != end && *p == '.')
+		{
+			if (++p == end || !IsDigit(*p))
+				return nullptr;
+			while (p != end && IsDigit(*p))
+				++p;
+		}
+		
+		if (p != end && (*p == 'e' || *p == 'E'))
+		{
+			if (++p != end && (*p == '+' || *p == '-'))
+				++p;
+			if (p == end || !IsDigit(*p))
+				return nullptr;
+			while (p != end && IsDigit(*p))
+				++p;
+		}
+		return p;
+	}
+	
+	/*	Returns the end of the value that starts at p. The extent of arrays and
+		objects is found by matching brackets outside of strings, without
+		validating their content.
+	*/
+	const char* SkipValue(const char *p, const char *end)
+	{
+		if (p == end)
+			return p;
+		
+		if (*p == '"')
+		{
+			const char *q = SkipString(p, end);
+			return q ? q : end;
+		}
+		
+		if (*p == '{' || *p == '[')
+		{
+			std::size_t depth = 0;
+			while (p != end)
+			{
+				switch (*p)
+				{
+				case '"':
+					p = SkipString(p, end);
+					if (!p)
+						return end;
+					continue;
+				
+				case '{':
+				case '[':
+					++depth;
+					break;
+				
+				case '}':
+				case ']':
+					if (--depth == 0)
+						return p + 1;
+					break;
+				
+				default:
+					break;
+				}
+				++p;
+			}
+			return end;
+		}
+		
+		// numbers and literals
+		while (p != end && *p != ',' && *p != '}' && *p != ']' && !IsSpace(*p))
+			++p;
+		return p;
+	}
+}
+
+LazyVar::LazyVar() : m_parsed(true)
+{
+}
+
+/**	Refers to the text of a value. Spaces around the value are ignored.
+*/
+LazyVar::LazyVar(const char *json, std::size_t len) :
+	m_parsed(false)
+{
+	const char *begin = SkipSpace(json, json + len);
+	const char *end   = json + len;
+	while (end != begin && IsSpace(end[-1]))
+		--end;
+	
+	m_raw = StringView{begin, end};
+}
+
+/**	Returns the type of the value. Only strings, numbers and literals are
+	parsed to find their types.
+*/
+json::Type LazyVar::Type() const
+{
+	if (!m_raw.empty() && *m_raw.data() == '{')
+		return json::Type::hash;
+	else if (!m_raw.empty() && *m_raw.data() == '[')
+		return json::Type::array;
+	
+	return Value().Type();
+}
+
+bool LazyVar::Is(json::Type type) const
+{
+	return Type() == type;
+}
+
+bool LazyVar::IsNull() const
+{
+	return Is(json::Type::null);
+}
+
+bool LazyVar::IsParsed() const
+{
+	return m_parsed;
+}
+
+/// The JSON text of the value.
+StringView LazyVar::Raw() const
+{
+	return m_raw;
+}
+
+/**	Returns the number of elements of an array or object, or zero for other
+	values. The array or object is parsed.
+*/
+std::size_t LazyVar::Size() const
+{
+	return Is(json::Type::array) || Is(json::Type::hash) ? Members().size() : 0;
+}
+
+/**	Returns a member of an object. The object is parsed, but not its members.
+	If the key appears more than once, the last value is returned.
+	
+	\throw	int	If the value is not an object or the key is not found.
+*/
+const LazyVar& LazyVar::operator[](const std::string& key) const
+{
+	if (!Is(json::Type::hash))
+		throw -1;
+	
+	const auto& members = Members();
+	auto it = std::find_if(members.rbegin(), members.rend(), [&key](const Member& m) { return m.first == key; });
+	if (it == members.rend())
+		throw -1;
+	
+	return it->second;
+}
+
+/**	Returns an element of an array. The array is parsed, but not its elements.
+
+	\throw	int					If the value is not an array.
+	\throw	std::out_of_range	If idx is not less than Size().
+*/
+const LazyVar& LazyVar::operator[](std::size_t idx) const
+{
+	if (!Is(json::Type::array))
+		throw -1;
+	
+	return Members().at(idx).second;
+}
+
+LazyVar::const_iterator LazyVar::begin() const
+{
+	return Members().begin();
+}
+
+LazyVar::const_iterator LazyVar::end() const
+{
+	return Members().end();
+}
+
+/**	Parses the whole value, including the values not accessed yet, to a JVar.
+*/
+JVar LazyVar::ToJVar(std::size_t depth) const
+{
+	if (!Is(json::Type::array) && !Is(json::Type::hash))
+		return Value();
+	
+	JVarBuilder h;
+	JsonParser parser(&h, depth);
+	
+	JVar result;
+	parser.Parse(m_raw.data(), m_raw.size(), &result);
+	parser.Done();
+	return result;
+}
+
+/**	Converts a string, number or literal to JVar when it is first read.
+
+	\throw	int	If the value is an array or object.
+	\throw	ParseError	If the text is empty or not a valid value.
+*/
+const JVar& LazyVar::Value() const
+{
+	if (m_parsed)
+		return m_value;
+	
+	const char *p   = m_raw.data();
+	const char *end = m_raw.end();
+	if (p == end)
+		Error(p);
+	
+	switch (*p)
+	{
+	case '{':
+	case '[':
+		throw -1;
+	
+	case '"':
+	{
+		const char *q = SkipString(p, end);
+		if (q != end)
+			Error(q ? q : end);
+		m_value = JVarBuilder::Scalar(JSON_string, p + 1, static_cast<std::size_t>(end - p) - 2);
+		break;
+	}
+	
+	case 't':
+	case 'f':
+	case 'n':
+		if (m_raw == "true")
+			m_value = JVar(true);
+		else if (m_raw == "false")
+			m_value = JVar(false);
+		else if (m_raw != "null")
+			Error(p);
+		break;
+	
+	default:
+		if (SkipNumber(p, end) != end)
+			Error(p);
+		m_value = JVarBuilder::Scalar(JSON_number, p, m_raw.size());
+		break;
+	}
+	
+	m_parsed = true;
+	return m_value;
+}
+
+/**	Parses one level of an array or object. The text of each element is found
+	without parsing it.
+*/
+const std::vector<LazyVar::Member>& LazyVar::Members() const
+{
+	if (m_members)
+		return *m_members;
+	
+	if (!Is(json::Type::array) && !Is(json::Type::hash))
+		throw -1;
+	
+	const char *p   = m_raw.data();
+	const char *end = m_raw.end();
+	
+	bool object = (*p == '{');
+	char close  = object ? '}' : ']';
+	
+	std::unique_ptr<std::vector<Member>> members(new std::vector<Member>);
+	
+	p = SkipSpace(p + 1, end);
+	bool more = (p == end || *p != close);
+	if (!more)
+		++p;
+	
+	while (more)
+	{
+		std::string key;
+		if (object)
+		{
+			const char *q = (p != end && *p == '"') ? SkipString(p, end) : nullptr;
+			if (!q)
+				Error(p);
+			
+			if (std::memchr(p, '\\', static_cast<std::size_t>(q - p)))
+				key = Unescape(p + 1, static_cast<std::size_t>(q - p) - 2);
+			else
+				key.assign(p + 1, q - 1);
+			
+			p = SkipSpace(q, end);
+			if (p == end || *p != ':')
+				Error(p);
+			p = SkipSpace(p + 1, end);
+		}
+		
+		const char *value = p;
+		p = SkipValue(p, end);
+		if (p == value)
+			Error(p);
+		members->emplace_back(std::move(key), LazyVar(value, static_cast<std::size_t>(p - value)));
+		
+		p = SkipSpace(p, end);
+		if (p != end && *p == ',')
+			p = SkipSpace(p + 1, end);
+		else if (p != end && *p == close)
+		{
+			++p;
+			more = false;
+		}
+		else
+			Error(p);
+	}
+	
+	if (p != end)
+		Error(p);
+	
+	m_members	= std::move(members);
+	m_parsed	= true;
+	return *m_members;
+}
+
+void LazyVar::Error(const char *pos) const
+{
+	const char *begin = m_raw.data();
+	std::size_t line  = static_cast<std::size_t>(std::count(begin, pos, '\n'));
+	
+	const char *line_start = pos;
+	while (line_start != begin && line_start[-1] != '\n')
+		--line_start;
+	
+	throw ParseError() << LineNumInfo(line) << ColumnNumInfo(static_cast<std::size_t>(pos - line_start));
+}
+
+LazyDocument::LazyDocument(std::string json) :
+	m_json(std::move(json)),
+	m_root(m_json.data(), m_json.size())
+{
+}
+
+const LazyVar& LazyDocument::Root() const
+{
+	return m_root;
+}
+
+} // end of namespace
@@ -0,0 +1,121 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef LAZYVAR_HH_INCLUDED
+#define LAZYVAR_HH_INCLUDED
+
+#include "JVar.hh"
+#include "StringView.hh"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+/**	A JSON value that is parsed when it is first accessed.
+
+	A LazyVar refers to the JSON text of a value without parsing it. When an
+	array or object is first accessed by operator[], Size() or iteration, only
+	its own level is parsed: each element or member becomes another LazyVar
+	that refers to its text. The extent of a nested container is found by
+	matching its brackets without looking at its content. Strings, numbers and
+	literals are converted to a JVar when they are first read.
+	
+	Errors in the text are only detected in the values that are accessed. Use
+	ToJVar() to parse and validate the whole value.
+	
+	A LazyVar does not copy the text, so the text must outlive it. Use
+	LazyDocument to keep the text together with its root. The values are parsed
+	by const functions, so a LazyVar must not be read by several threads.
+	
+	\code{.cpp}
+	LazyVar doc(json, len);
+	std::cout << doc["items"][0]["id"].Str();	// the other items are not parsed
+	\endcode
+*/
+class LazyVar
+{
+public:
+	//! Members of an object, or elements of an array with empty keys.
+	using Member = std::pair<std::string, LazyVar>;
+	using const_iterator = std::vector<Member>::const_iterator;
+
+public:
+	LazyVar();
+	LazyVar(const char *json, std::size_t len);
+	
+	json::Type Type() const;
+	bool Is(json::Type type) const;
+	bool IsNull() const;
+	bool IsParsed() const;
+	StringView Raw() const;
+	
+	int Int() const					{return Value().Int();}
+	long long Long() const			{return Value().Long();}
+	double Real() const				{return Value().Real();}
+	bool Bool() const				{return Value().Bool();}
+	StringView Str() const			{return Value().Str();}
+	
+	std::size_t Size() const;
+	const LazyVar& operator[](const std::string& key) const;
+	const LazyVar& operator[](std::size_t idx) const;
+	
+	const_iterator begin() const;
+	const_iterator end() const;
+	
+	JVar ToJVar(std::size_t depth = 10) const;
+	
+private:
+	const JVar& Value() const;
+	const std::vector<Member>& Members() const;
+	
+	[[noreturn]] void Error(const char *pos) const;
+	
+private:
+	StringView	m_raw;		//!< the text of the value without spaces around it
+	
+	// parsed when first accessed
+	mutable bool									m_parsed;
+	mutable JVar									m_value;
+	mutable std::unique_ptr<std::vector<Member>>	m_members;
+};
+
+/**	A LazyVar that owns its JSON text.
+*/
+class LazyDocument
+{
+public:
+	explicit LazyDocument(std::string json);
+	LazyDocument(const LazyDocument&) = delete;
+	LazyDocument& operator=(const LazyDocument&) = delete;
+	
+	const LazyVar& Root() const;
+	
+private:
+	std::string	m_json;
+	LazyVar		m_root;
+};
+
+} // end of namespace
+
+#endif
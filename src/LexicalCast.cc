@@ -19,39 +19,391 @@
 */
 
 #include "LexicalCast.hh"
+#include "Exception.hh"
 
-#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
 
 namespace json {
 
+namespace detail {
+	// in PowerOfFive.cc
+	extern const std::uint64_t power_of_five_128[];
+}
+
+namespace
+{
+	[[noreturn]] void ThrowOutOfRange(const char *str, std::size_t len)
+	{
+		throw OutOfRange() << NumberInfo(std::string(str, len));
+	}
+
+	bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	// SWAR: check and convert 8 digits at a time
+	// see http://govnokod.ru/13461 and https://lemire.me/blog/2022/01/21/swar-explained-parsing-eight-digits/
+	bool Is8Digits(std::uint64_t v)
+	{
+		return (((v & 0xF0F0F0F0F0F0F0F0ULL) |
+			(((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+	}
+
+	std::uint32_t Parse8Digits(std::uint64_t v)
+	{
+		const std::uint64_t mask = 0x000000FF000000FFULL;
+		const std::uint64_t mul1 = 0x000F424000000064ULL;	// 100 + (1000000ULL << 32)
+		const std::uint64_t mul2 = 0x0000271000000001ULL;	// 1 + (10000ULL << 32)
+		v -= 0x3030303030303030ULL;
+		v = (v * 10) + (v >> 8);
+		v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+		return static_cast<std::uint32_t>(v);
+	}
+	
+	bool Try8Digits(const char *p, const char *end, std::uint64_t& value)
+	{
+		std::uint64_t v;
+		if (end - p < 8)
+			return false;
+		
+		std::memcpy(&v, p, sizeof(v));
+		if (!Is8Digits(v))
+			return false;
+		
+		value = value * 100000000 + Parse8Digits(v);
+		return true;
+	}
+#else
+	bool Try8Digits(const char*, const char*, std::uint64_t&)
+	{
+		return false;
+	}
+#endif
+
+	/*	Parses the digits at p into value. Stops at the first non-digit.
+		\return	false if the value overflows.
+	*/
+	bool ParseDigits(const char *&p, const char *end, std::uint64_t& value)
+	{
+		// 19 digits always fit in 64 bits
+		const char *fast_end = p + std::min<std::ptrdiff_t>(end - p, 19);
+		while (fast_end - p >= 8 && Try8Digits(p, end, value))
+			p += 8;
+		while (p != fast_end && IsDigit(*p))
+			value = value * 10 + static_cast<unsigned>(*p++ - '0');
+		
+		bool ok = true;
+		for ( ; p != end && IsDigit(*p) ; ++p)
+		{
+			unsigned d = static_cast<unsigned>(*p - '0');
+			if (value > (std::numeric_limits<std::uint64_t>::max() - d) / 10)
+				ok = false;
+			value = value * 10 + d;
+		}
+		return ok;
+	}
+
+	/*	Parses an integer like atoi(), but without copying and with range check.
+		Characters after the digits (e.g. the fraction) are ignored.
+	*/
+	template <typename Int>
+	Int ParseInteger(const char *str, std::size_t len)
+	{
+		if (str == nullptr)
+			return 0;
+		
+		const char *p = str, *end = str + len;
+		bool neg = (p != end && *p == '-');
+		if (neg || (p != end && *p == '+'))
+			++p;
+
+		std::uint64_t mag = 0;
+		if (!ParseDigits(p, end, mag))
+			ThrowOutOfRange(str, len);
+		
+		using Limits = std::numeric_limits<Int>;
+		if (neg)
+		{
+			// the magnitude of the minimum is one more than the maximum
+			if (mag > static_cast<std::uint64_t>(Limits::max()) + (Limits::is_signed ? 1 : 0) ||
+				(!Limits::is_signed && mag != 0))
+				ThrowOutOfRange(str, len);
+			
+			return static_cast<Int>(0 - mag);
+		}
+		else if (mag > static_cast<std::uint64_t>(Limits::max()))
+			ThrowOutOfRange(str, len);
+		
+		return static_cast<Int>(mag);
+	}
+	
+	void FullMultiply(std::uint64_t a, std::uint64_t b, std::uint64_t& hi, std::uint64_t& lo)
+	{
+#ifdef __SIZEOF_INT128__
+		unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+		hi = static_cast<std::uint64_t>(r >> 64);
+		lo = static_cast<std::uint64_t>(r);
+#else
+		std::uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+		std::uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+		std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+		std::uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+		hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+		lo = (mid << 32) | (ll & 0xFFFFFFFF);
+#endif
+	}
+
+	int LeadingZeros(std::uint64_t v)
+	{
+#if defined(__GNUC__)
+		return __builtin_clzll(v);
+#else
+		int n = 0;
+		for (std::uint64_t bit = 1ULL << 63 ; (v & bit) == 0 ; bit >>= 1)
+			++n;
+		return n;
+#endif
+	}
+
+	double MakeDouble(bool neg, std::uint64_t mantissa, int power2)
+	{
+		std::uint64_t bits = mantissa | (static_cast<std::uint64_t>(power2) << 52) | (neg ? 1ULL << 63 : 0);
+		double d;
+		std::memcpy(&d, &bits, sizeof(d));
+		return d;
+	}
+	
+	/*	The Eisel-Lemire algorithm: computes w * 10^q correctly rounded, with the help of
+		the 128-bit approximation of 5^q.
+		See Daniel Lemire, "Number Parsing at a Gigabyte per Second" and the fast_float
+		library.
+
+		\return	the biased exponent and the explicit bits of the mantissa.
+	*/
+	void EiselLemire(std::int64_t q, std::uint64_t w, std::uint64_t& mantissa, int& power2)
+	{
+		const int mantissa_bits = 52;
+		const int min_exponent  = -1023;
+		const int inf_power     = 0x7FF;
+		
+		mantissa = 0;
+		power2   = 0;
+		if (w == 0 || q < -342)
+			return;
+		if (q > 308)
+		{
+			power2 = inf_power;
+			return;
+		}
+		
+		int lz = LeadingZeros(w);
+		w <<= lz;
+		
+		// multiply by the 128-bit approximation of 5^q. The second word is only needed
+		// when the lower bits of the first product are all ones.
+		std::size_t index = 2 * static_cast<std::size_t>(q + 342);
+		std::uint64_t hi, lo;
+		FullMultiply(w, detail::power_of_five_128[index], hi, lo);
+		
+		const std::uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFULL >> (mantissa_bits + 3);
+		if ((hi & precision_mask) == precision_mask)
+		{
+			std::uint64_t hi2, lo2;
+			FullMultiply(w, detail::power_of_five_128[index+1], hi2, lo2);
+			lo += hi2;
+			if (hi2 > lo)
+				hi++;
+		}
+		
+		int upperbit = static_cast<int>(hi >> 63);
+		int shift    = upperbit + 64 - mantissa_bits - 3;
+		mantissa     = hi >> shift;
+		
+		// 217706 / 2^16 approximates log2(10)
+		power2 = static_cast<int>((((152170 + 65536) * q) >> 16) + 63) + upperbit - lz - min_exponent;
+		
+		// subnormal
+		if (power2 <= 0)
+		{
+			if (-power2 + 1 >= 64)
+			{
+				mantissa = 0;
+				power2   = 0;
+				return;
+			}
+			mantissa >>= -power2 + 1;
+			mantissa += (mantissa & 1);
+			mantissa >>= 1;
+			power2 = (mantissa < (1ULL << mantissa_bits)) ? 0 : 1;
+			mantissa &= ~(1ULL << mantissa_bits);
+			return;
+		}
+		
+		// exactly halfway between two doubles: round to even
+		if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+			mantissa &= ~1ULL;
+		
+		mantissa += (mantissa & 1);
+		mantissa >>= 1;
+		if (mantissa >= (2ULL << mantissa_bits))
+		{
+			mantissa = 1ULL << mantissa_bits;
+			power2++;
+		}
+		mantissa &= ~(1ULL << mantissa_bits);
+		
+		if (power2 >= inf_power)
+		{
+			power2   = inf_power;
+			mantissa = 0;
+		}
+	}
+	
+	// the slow path for long numbers that Eisel-Lemire cannot decide
+	double ParseDoubleSlow(const char *str, std::size_t len)
+	{
+		std::istringstream ss(std::string(str, len));
+		ss.imbue(std::locale::classic());
+		
+		double d = 0.0;
+		ss >> d;
+		return d;
+	}
+}
+
 template <>
 std::int32_t LexicalCast(const char *str, std::size_t len)
 {
-	return str != nullptr ? std::atoi(std::string(str, len).c_str()) : 0;
+	return ParseInteger<std::int32_t>(str, len);
 }
 
 template <>
 std::uint32_t LexicalCast(const char *str, std::size_t len)
 {
-	return str != nullptr ? static_cast<std::uint32_t>(std::atoi(std::string(str, len).c_str())) : 0U;
+	return ParseInteger<std::uint32_t>(str, len);
 }
 
 template <>
 std::int64_t LexicalCast(const char *str, std::size_t len)
 {
-	return str != nullptr ? std::strtoll(std::string(str, len).c_str(), nullptr, 10) : 0ULL;
+	return ParseInteger<std::int64_t>(str, len);
 }
 
 template <>
 std::uint64_t LexicalCast(const char *str, std::size_t len)
 {
-	return str != nullptr ? std::strtoull(std::string(str, len).c_str(), nullptr, 10) : 0ULL;
+	return ParseInteger<std::uint64_t>(str, len);
 }
 
+/**	Converts a JSON number to double without copying.
+
+	The result is correctly rounded. Characters after the number are ignored,
+	like atof().
+	
+	\throw	OutOfRange	If the number is too large for a double.
+*/
 template <>
 double LexicalCast(const char *str, std::size_t len)
 {
-	return str != nullptr ? std::atof(std::string(str, len).c_str()) : 0.0;
+	if (str == nullptr)
+		return 0.0;
+	
+	const char *p = str, *end = str + len;
+	bool neg = (p != end && *p == '-');
+	if (neg || (p != end && *p == '+'))
+		++p;
+	
+	// up to 19 significant digits are kept in w. The value is w * 10^exp10.
+	std::uint64_t w = 0;
+	std::int64_t exp10 = 0;
+	int digits = 0;
+	bool truncated = false;
+	
+	const char *int_start = p;
+	for ( ; p != end && *p == '0' ; ++p) {}
+	for ( ; p != end && IsDigit(*p) ; ++p)
+	{
+		if (digits < 19)
+			w = w * 10 + static_cast<unsigned>(*p - '0'), ++digits;
+		else
+			++exp10, truncated = truncated || *p != '0';
+	}
+	bool has_digits = (p != int_start);
+	
+	if (p != end && *p == '.')
+	{
+		const char *frac_start = ++p;
+		if (w == 0)
+			for ( ; p != end && *p == '0' ; ++p)
+				--exp10;
+		for ( ; p != end && IsDigit(*p) ; ++p)
+		{
+			if (digits < 19)
+				w = w * 10 + static_cast<unsigned>(*p - '0'), ++digits, --exp10;
+			else
+				truncated = truncated || *p != '0';
+		}
+		has_digits = has_digits || p != frac_start;
+	}
+	if (!has_digits)
+		return 0.0;
+	
+	if (p != end && (*p == 'e' || *p == 'E'))
+	{
+		const char *exp_start = p++;
+		bool exp_neg = (p != end && *p == '-');
+		if (exp_neg || (p != end && *p == '+'))
+			++p;
+		
+		if (p != end && IsDigit(*p))
+		{
+			std::int64_t e = 0;
+			for ( ; p != end && IsDigit(*p) ; ++p)
+				if (e < 100000)
+					e = e * 10 + (*p - '0');
+			exp10 += exp_neg ? -e : e;
+		}
+		else
+			p = exp_start;
+	}
+	
+	// Clinger's fast path: both w and the power of 10 are exact in double
+	static const double exact_pow10[] =
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	if (!truncated && w <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+	{
+		double d = static_cast<double>(w);
+		d = exp10 < 0 ? d / exact_pow10[-exp10] : d * exact_pow10[exp10];
+		return neg ? -d : d;
+	}
+	
+	std::uint64_t mantissa;
+	int power2;
+	EiselLemire(exp10, w, mantissa, power2);
+	
+	// with digits truncated, the value is between w and w+1
+	if (truncated)
+	{
+		std::uint64_t mantissa1;
+		int power2_1;
+		EiselLemire(exp10, w+1, mantissa1, power2_1);
+		if (mantissa != mantissa1 || power2 != power2_1)
+			return ParseDoubleSlow(str, static_cast<std::size_t>(p - str));
+	}
+	
+	if (power2 == 0x7FF)
+		ThrowOutOfRange(str, len);
+	
+	return MakeDouble(neg, mantissa, power2);
 }
 
 template <>
@@ -60,15 +412,77 @@ std::string LexicalCast(const char *str, std::size_t len)
 	return str != nullptr ? std::string(str, len) : "";
 }
 
+template <>
+StringView LexicalCast(const char *str, std::size_t len)
+{
+	return str != nullptr ? StringView{str, str + len} : StringView{nullptr, nullptr};
+}
+
+void LexicalAssign(std::string& dest, const char *str, std::size_t len)
+{
+	if (str != nullptr)
+		dest.assign(str, len);
+	else
+		dest.clear();
+}
+
 template <>
 bool LexicalCast(const char *str, std::size_t len)
 {
-	return str != nullptr && std::string(str, len) == "true" ;
+	return str != nullptr && len == 4 && std::memcmp(str, "true", 4) == 0 ;
+}
+
+namespace
+{
+	// returns -1 if not a valid \uXXXX escape sequence
+	long HexQuad(const char *str, std::size_t len)
+	{
+		if (len < 4)
+			return -1;
+
+		long code = 0;
+		for (std::size_t i = 0 ; i < 4 ; ++i)
+		{
+			char c = str[i];
+			int digit =	(c >= '0' && c <= '9') ? c - '0' :
+						(c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+						(c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+			if (digit < 0)
+				return -1;
+			code = code * 16 + digit;
+		}
+		return code;
+	}
+
+	void AppendUtf8(std::string& out, unsigned long code)
+	{
+		if (code < 0x80)
+			out.push_back(static_cast<char>(code));
+		else if (code < 0x800)
+		{
+			out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+			out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+		}
+		else if (code < 0x10000)
+		{
+			out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+			out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+		}
+		else
+		{
+			out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+			out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+		}
+	}
 }
 
 std::string Unescape(const char *str, std::size_t len)
 {
 	std::string result;
+	result.reserve(len);
 	for (std::size_t i = 0 ; i < len ; ++i)
 	{
 		char c = str[i];
@@ -79,12 +493,32 @@ std::string Unescape(const char *str, std::size_t len)
 			{
 				case '\"': c = '"' ;	break;
 				case '\\': c = '\\' ;	break;
+				case '/': c = '/' ;		break;
 				case 'b': c = '\b' ;	break;
 				case 'f': c = '\f' ;	break;
 				case 'n': c = '\n' ;	break;
 				case 'r': c = '\r' ;	break;
 				case 't': c = '\t' ;	break;
-//				case 'u': c = '\\' ;	break;
+				case 'u':
+				{
+					long code = HexQuad(str+i+1, len-i-1);
+					if (code < 0)
+						return result;
+					i += 4;
+					
+					// UTF-16 surrogate pair
+					if (code >= 0xD800 && code < 0xDC00 && i+2 < len && str[i+1] == '\\' && str[i+2] == 'u')
+					{
+						long low = HexQuad(str+i+3, len-i-3);
+						if (low >= 0xDC00 && low < 0xE000)
+						{
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+							i += 6;
+						}
+					}
+					AppendUtf8(result, static_cast<unsigned long>(code));
+					continue;
+				}
 				
 				// truncate the string when error occurs
 				default:	return result;
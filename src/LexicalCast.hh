@@ -21,6 +21,8 @@
 #ifndef LEXICALCAST_HH_INCLUDED
 #define LEXICALCAST_HH_INCLUDED
 
+#include "StringView.hh"
+
 #include <string>
 #include <cstdint>
 
@@ -50,6 +52,27 @@ bool LexicalCast(const char *str, std::size_t len);
 template <>
 std::string LexicalCast(const char *str, std::size_t len);
 
+/**	Refers to the JSON text without copying it.
+
+	The text is not unescaped. It is only valid as long as the input buffer
+	given to the parser.
+*/
+template <>
+StringView LexicalCast(const char *str, std::size_t len);
+
+/**	Assigns the converted value to dest.
+
+	The overload for std::string assigns the text in place, reusing the
+	capacity of dest instead of creating a temporary string.
+*/
+template <typename Dest>
+void LexicalAssign(Dest& dest, const char *str, std::size_t len)
+{
+	dest = LexicalCast<Dest>(str, len);
+}
+
+void LexicalAssign(std::string& dest, const char *str, std::size_t len);
+
 std::string Unescape(const char *str, std::size_t len);
 std::string Unescape(const std::string& str);
 
@@ -0,0 +1,245 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef MAPBUILDER_HH_INCLUDED
+#define MAPBUILDER_HH_INCLUDED
+
+#include "TypeBuilder.hh"
+#include "LexicalCast.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+template <typename Host> class JsonBuilder;
+
+namespace detail
+{
+	// the keys of the parser are escaped JSON text
+	inline std::string MapKey(const Key& key)
+	{
+		auto data = key.Data();
+		return data.size() > 0 && std::memchr(data.begin(), '\\', data.size()) ?
+			Unescape(data.begin(), data.size()) :
+			std::string(data.begin(), data.end());
+	}
+	
+	// writes the entries of a map or FlatMap with the value builder
+	template <typename Map>
+	void WriteMap(const Map& map, const JsonProcessor *visitor, Writer& out)
+	{
+		bool first = true;
+		out.Raw('{');
+		for (const auto& entry : map)
+		{
+			if (!first)
+				out.Raw(',');
+			out.String(entry.first.data(), entry.first.size());
+			out.Raw(':');
+			visitor->Write(WriteCursor(Key{entry.first}, entry.second, visitor), out);
+			first = false;
+		}
+		out.Raw('}');
+	}
+}
+
+/**	Builds a map from a JSON object whose keys are not known in advance.
+
+	Each member of the object becomes an entry of the map. The values are built
+	directly in the map by the value builder. If a key appears twice, the value
+	is built again on the existing entry.
+	
+	\param	T	The type of the values.
+	\param	Map	A map from std::string to T, e.g. std::map or std::unordered_map.
+*/
+template <typename T, typename Map=std::map<std::string, T>>
+class MapBuilder : public TypeBuilder<Map>
+{
+public:
+	using HostType = Map;
+	
+public:
+	MapBuilder(const MapBuilder&) = default;
+#ifndef _MSC_VER
+	MapBuilder(MapBuilder&&) = default;
+#endif
+	~MapBuilder() override = default;
+	
+	template <typename Builder=JsonBuilder<T>>
+	MapBuilder(const Builder& v) : m_visitor(std::make_shared<Builder>(v))
+	{
+		static_assert(
+			std::is_base_of<TypeBuilder<T>, Builder>::value,
+			"member type and visitor does not match");
+	}
+
+	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override
+	{
+		assert(this->Check(current));
+		
+		if (current.Key().IsKey())
+			m_visitor->Data(Cursor{current.Key(), Value(current), m_visitor.get()}, type, data, len);
+	}
+	
+	Cursor Advance(const Cursor& current) const override
+	{
+		assert(this->Check(current));
+		
+		return current.Key().IsKey() ?
+			Cursor{current.Key(), Value(current), m_visitor.get()} :
+			Cursor{current.Key()};
+	}
+
+	void Finish(const Cursor& current) const override
+	{
+		assert(this->Check(current));
+	}
+	
+	void Write(const Cursor& current, Writer& out) const override
+	{
+		assert(this->Check(current));
+		detail::WriteMap(*current.Target<HostType>(), m_visitor.get(), out);
+	}
+
+private:
+	T* Value(const Cursor& current) const
+	{
+		return &(*current.Target<HostType>())[detail::MapKey(current.Key())];
+	}
+	
+private:
+	std::shared_ptr<const JsonProcessor>	m_visitor;
+};
+
+/**	A map stored in a vector sorted by the keys.
+
+	It takes less memory than std::map and is faster to iterate. Use FlatMapFind()
+	to look up a key.
+*/
+template <typename T>
+using FlatMap = std::vector<std::pair<std::string, T>>;
+
+template <typename T>
+const T* FlatMapFind(const FlatMap<T>& map, const std::string& key)
+{
+	auto it = std::lower_bound(map.begin(), map.end(), key,
+		[](const std::pair<std::string, T>& entry, const std::string& k) { return entry.first < k; });
+	return it != map.end() && it->first == key ? &it->second : nullptr;
+}
+
+/**	Builds a FlatMap from a JSON object whose keys are not known in advance.
+
+	The values are appended in the order of the JSON object and then sorted by
+	their keys when the object ends. If a key appears more than once, the last
+	value is kept.
+*/
+template <typename T>
+class FlatMapBuilder : public TypeBuilder<FlatMap<T>>
+{
+public:
+	using HostType = FlatMap<T>;
+	
+public:
+	FlatMapBuilder(const FlatMapBuilder&) = default;
+#ifndef _MSC_VER
+	FlatMapBuilder(FlatMapBuilder&&) = default;
+#endif
+	~FlatMapBuilder() override = default;
+	
+	template <typename Builder=JsonBuilder<T>>
+	FlatMapBuilder(const Builder& v) : m_visitor(std::make_shared<Builder>(v))
+	{
+		static_assert(
+			std::is_base_of<TypeBuilder<T>, Builder>::value,
+			"member type and visitor does not match");
+	}
+
+	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override
+	{
+		assert(this->Check(current));
+		
+		if (current.Key().IsKey())
+			m_visitor->Data(Cursor{current.Key(), Append(current), m_visitor.get()}, type, data, len);
+	}
+	
+	Cursor Advance(const Cursor& current) const override
+	{
+		assert(this->Check(current));
+		
+		return current.Key().IsKey() ?
+			Cursor{current.Key(), Append(current), m_visitor.get()} :
+			Cursor{current.Key()};
+	}
+
+	void Finish(const Cursor& current) const override
+	{
+		assert(this->Check(current));
+		
+		auto host = current.Target<HostType>();
+		std::stable_sort(host->begin(), host->end(), &KeyLess);
+		
+		// keep the last of the values with the same key
+		auto out = host->begin();
+		for (auto it = host->begin() ; it != host->end() ; ++it)
+		{
+			auto next = it + 1;
+			if (next == host->end() || next->first != it->first)
+			{
+				if (out != it)
+					*out = std::move(*it);
+				++out;
+			}
+		}
+		host->erase(out, host->end());
+	}
+	
+	void Write(const Cursor& current, Writer& out) const override
+	{
+		assert(this->Check(current));
+		detail::WriteMap(*current.Target<HostType>(), m_visitor.get(), out);
+	}
+
+private:
+	static bool KeyLess(const typename HostType::value_type& e1, const typename HostType::value_type& e2)
+	{
+		return e1.first < e2.first;
+	}
+	
+	T* Append(const Cursor& current) const
+	{
+		auto host = current.Target<HostType>();
+		host->emplace_back(detail::MapKey(current.Key()), T());
+		return &host->back().second;
+	}
+	
+private:
+	std::shared_ptr<const JsonProcessor>	m_visitor;
+};
+
+} // end of namespace
+
+#endif
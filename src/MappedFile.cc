@@ -0,0 +1,141 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "MappedFile.hh"
+#include "Exception.hh"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JSON_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+#include <cerrno>
+
+namespace json {
+
+#ifdef JSON_USE_MMAP
+
+namespace
+{
+	[[noreturn]] void Error(const std::string& path, int fd)
+	{
+		int err = errno;
+		if (fd >= 0)
+			::close(fd);
+		throw FileError() << FileNameInfo(path) << ErrnoInfo(err);
+	}
+}
+
+MappedFile::MappedFile(const std::string& path) : m_data(""), m_size(0), m_mapped(false)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		Error(path, fd);
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0)
+		Error(path, fd);
+
+	// pipes and devices cannot be mapped, and the size of /proc files is
+	// zero, so they are read until the end
+	if (!S_ISREG(st.st_mode))
+	{
+		char buf[64 * 1024];
+		for (;;)
+		{
+			ssize_t len = ::read(fd, buf, sizeof(buf));
+			if (len < 0 && errno == EINTR)
+				continue;
+			if (len < 0)
+				Error(path, fd);
+			if (len == 0)
+				break;
+			m_buf.append(buf, static_cast<std::size_t>(len));
+		}
+		m_data = m_buf.data();
+		m_size = m_buf.size();
+	}
+
+	// empty files cannot be mapped
+	else if (st.st_size > 0)
+	{
+		m_size = static_cast<std::size_t>(st.st_size);
+
+		void *addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED)
+			Error(path, fd);
+		m_data   = static_cast<const char*>(addr);
+		m_mapped = true;
+
+		// only hints: failures are harmless
+#ifdef MADV_SEQUENTIAL
+		::madvise(addr, m_size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+		::madvise(addr, m_size, MADV_HUGEPAGE);
+#endif
+	}
+
+	// the mapping stays valid after the file is closed
+	::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_mapped)
+		::munmap(const_cast<char*>(m_data), m_size);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) : m_data(""), m_size(0), m_mapped(false)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file)
+		throw FileError() << FileNameInfo(path) << ErrnoInfo(errno);
+
+	m_buf.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	m_data = m_buf.data();
+	m_size = m_buf.size();
+}
+
+MappedFile::~MappedFile()
+{
+}
+
+#endif
+
+const char* MappedFile::Data() const
+{
+	return m_data;
+}
+
+std::size_t MappedFile::Size() const
+{
+	return m_size;
+}
+
+} // end of namespace
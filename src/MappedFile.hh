@@ -0,0 +1,62 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef MAPPEDFILE_HH_INCLUDED
+#define MAPPEDFILE_HH_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+namespace json {
+
+/**	A read-only view of the whole content of a file.
+
+	On POSIX systems the file is mapped into memory, so the content is not
+	copied and the pages are read by the kernel on demand. The mapping is
+	advised to be read sequentially, which enables aggressive read-ahead, and
+	to use huge pages where the system supports them. Only clean pages of the
+	page cache are used, so parsing a large file does not need another copy of
+	it in memory. Files that cannot be mapped, such as pipes and /proc files,
+	and all files on other systems are read into a buffer instead.
+
+	A FileError is thrown if the file cannot be opened or mapped.
+*/
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* Data() const;
+	std::size_t Size() const;
+
+private:
+	const char	*m_data;
+	std::size_t	m_size;
+	bool		m_mapped;
+	std::string	m_buf;	//!< content of the file if it cannot be mapped
+};
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,183 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "ReadAhead.hh"
+#include "Exception.hh"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#else
+#include <io.h>
+#define read _read
+#endif
+
+#include <cassert>
+#include <cerrno>
+#include <utility>
+
+namespace json {
+
+/**	Reads a file descriptor, retrying if interrupted by a signal.
+
+	\return	The number of bytes read, or zero at the end of file.
+	\throw	FileError with ErrnoInfo if read() fails.
+*/
+std::size_t ReadFd(int fd, char *buf, std::size_t size)
+{
+	long result;
+	do
+		result = ::read(fd, buf, size);
+	while (result < 0 && errno == EINTR);
+
+	if (result < 0)
+		throw FileError() << ErrnoInfo(errno);
+	return static_cast<std::size_t>(result);
+}
+
+const std::size_t ReadAhead::default_chunk_size;
+
+ReadAhead::ReadAhead(int fd, std::size_t chunk, std::size_t count) :
+	ReadAhead([fd](char *buf, std::size_t size){ return ReadFd(fd, buf, size); }, chunk, count)
+{
+}
+
+ReadAhead::ReadAhead(Source source, std::size_t chunk, std::size_t count) :
+	m_source(std::move(source)),
+	m_ring(count),
+	m_head(0),
+	m_filled(0),
+	m_holding(false),
+	m_eof(false),
+	m_stop(false)
+{
+	assert(chunk > 0);
+	assert(count > 0);
+
+	for (auto& slot : m_ring)
+	{
+		slot.buf.resize(chunk);
+		slot.len = 0;
+	}
+
+	// start the thread after all members are initialized
+	m_thread = std::thread(&ReadAhead::Run, this);
+}
+
+/**	Stops the I/O thread.
+
+	The destructor waits for the read() in progress, if any, to return.
+*/
+ReadAhead::~ReadAhead()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	m_thread.join();
+}
+
+/**	Gets the next chunk of the input.
+
+	The chunk returned previously is given back to the I/O thread to be
+	filled again. If the source throws, the chunks read before the error are
+	still returned, and then the exception is thrown again by Next().
+
+	\return	false at the end of the input.
+*/
+bool ReadAhead::Next(const char *& data, std::size_t& len)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_holding)
+	{
+		m_holding = false;
+		m_cond.notify_all();
+	}
+
+	m_cond.wait(lock, [this]{ return m_filled > 0 || m_eof; });
+	if (m_filled == 0)
+	{
+		if (m_error)
+			std::rethrow_exception(m_error);
+		return false;
+	}
+
+	const Slot& slot = m_ring[m_head];
+	m_head = (m_head + 1) % m_ring.size();
+	--m_filled;
+	m_holding = true;
+
+	data = slot.buf.data();
+	len  = slot.len;
+	return true;
+}
+
+/**	The loop of the I/O thread. The slots are filled in the same order as
+	they are returned by Next().
+*/
+void ReadAhead::Run()
+{
+	for (std::size_t i = 0 ; ; i = (i + 1) % m_ring.size())
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cond.wait(lock, [this]
+			{
+				return m_stop || m_filled + (m_holding ? 1 : 0) < m_ring.size();
+			});
+			if (m_stop)
+				return;
+		}
+
+		// the slot is neither filled nor held by the caller, so it can be
+		// written without holding the lock
+		Slot& slot = m_ring[i];
+		std::size_t len = 0;
+		std::exception_ptr error;
+		try
+		{
+			len = m_source(slot.buf.data(), slot.buf.size());
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (len > 0)
+			{
+				slot.len = len;
+				++m_filled;
+			}
+			else
+			{
+				m_error = error;
+				m_eof   = true;
+			}
+		}
+		m_cond.notify_all();
+
+		if (len == 0)
+			return;
+	}
+}
+
+} // end of namespace
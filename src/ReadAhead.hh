@@ -0,0 +1,117 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef READAHEAD_HH_INCLUDED
+#define READAHEAD_HH_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace json {
+
+std::size_t ReadFd(int fd, char *buf, std::size_t size);
+
+/**	Reads a file descriptor on another thread while the data is being parsed.
+
+	ReadAhead keeps a ring of buffers. An I/O thread fills the free buffers
+	with read(), or with another Source such as a Decompressor, and Next()
+	gives the filled buffers to the caller in order. With two or more buffers,
+	the next chunk is read while the previous one is being parsed, so the time
+	spent waiting for a slow disk or pipe overlaps with the time spent parsing.
+
+	A buffer returned by Next() stays valid until Next() is called again.
+	Automaton and JsonParser copy the incomplete token at the end of a chunk
+	before Parse() returns, and the copy grows to hold a token of any length,
+	so each chunk can be given to Parse() directly:
+
+	\code{.cpp}
+	ReadAhead input(fd);
+	input.Feed(parser);
+	\endcode
+
+	The file descriptor is not closed by ReadAhead.
+*/
+class ReadAhead
+{
+public:
+	/**	Fills a buffer on the I/O thread.
+	
+		\return	The number of bytes written to the buffer, or zero at the end of
+				the input. Exceptions are thrown to the caller of Next().
+	*/
+	using Source = std::function<std::size_t (char *buf, std::size_t size)>;
+
+	static const std::size_t default_chunk_size = 1024 * 1024;
+
+public:
+	explicit ReadAhead(int fd, std::size_t chunk = default_chunk_size, std::size_t count = 2);
+	explicit ReadAhead(Source source, std::size_t chunk = default_chunk_size, std::size_t count = 2);
+	~ReadAhead();
+
+	ReadAhead(const ReadAhead&) = delete;
+	ReadAhead& operator=(const ReadAhead&) = delete;
+
+	bool Next(const char *& data, std::size_t& len);
+
+	/**	Gives all chunks to the Parse() function of \a parser.
+	*/
+	template <typename Parser>
+	void Feed(Parser& parser)
+	{
+		const char *data;
+		std::size_t len;
+		while (Next(data, len))
+			parser.Parse(data, len);
+	}
+
+private:
+	void Run();
+
+private:
+	struct Slot
+	{
+		std::vector<char>	buf;
+		std::size_t			len;
+	};
+
+	Source				m_source;
+	std::vector<Slot>	m_ring;
+
+	// states shared with the I/O thread
+	std::mutex				m_mutex;
+	std::condition_variable	m_cond;
+	std::size_t				m_head;		//!< index of the next filled slot
+	std::size_t				m_filled;	//!< number of filled slots
+	bool					m_holding;	//!< whether the caller holds the slot before m_head
+	bool					m_eof;
+	bool					m_stop;
+	std::exception_ptr		m_error;	//!< thrown by m_source
+
+	std::thread				m_thread;
+};
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,154 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef STATICBUILDER_HH_INCLUDED
+#define STATICBUILDER_HH_INCLUDED
+
+#include "LexicalCast.hh"
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace json {
+
+/**	\file StaticBuilder.hh
+	Schemas that describe how to build C++ objects from JSON at compile time.
+
+	Unlike JsonBuilder, the types of all members in a static schema are part of
+	the type of the schema. StaticParser uses the schema type to generate the
+	parsing code of the whole object tree, so there are no virtual functions
+	and type checks when parsing. Use JsonBuilder if the mapping is only known
+	at run time.
+
+	\code{.cpp}
+	const auto schema = MakeObject<Book>(
+		MakeMember("title",  &Book::title),
+		MakeMember("pages",  &Book::pages),
+		MakeMember("author", &Book::author, MakeObject<Person>(
+			MakeMember("name", &Person::name)))
+	);
+	StaticParser<decltype(schema)> parser(schema);
+	parser.Parse(json, len, &book);
+	\endcode
+*/
+
+/**	Schema of a string, number or boolean.
+
+	The JSON value is converted to T by LexicalCast(). A StringView member
+	refers to the escaped text in the buffer given to StaticParser::Parse().
+*/
+template <typename T>
+struct StaticValue
+{
+	static_assert(
+		std::is_arithmetic<T>::value || std::is_same<T, std::string>::value ||
+		std::is_same<T, StringView>::value,
+		"a schema is required to build members of class types");
+
+	using HostType = T;
+};
+
+/**	Schema of an array. Each element is appended to a container by emplace_back()
+	and then built by the element schema.
+*/
+template <typename ElemSchema>
+struct StaticArray
+{
+	ElemSchema	elem;
+};
+
+/**	Schema of a member of Host, which is built from the value of a key.
+
+	The key is not copied. It is a string literal given to MakeMember().
+*/
+template <typename Host, typename T, typename Schema>
+struct StaticMember
+{
+	const char	*key;
+	std::size_t	len;
+	T Host::*	mem;
+	Schema		schema;
+};
+
+/**	Schema of a class, which is built from a JSON object. The members are
+	matched in the order they are given.
+*/
+template <typename Host, typename... Members>
+struct StaticObject
+{
+	using HostType = Host;
+
+	std::tuple<Members...>	members;
+};
+
+/**	The schema used by MakeMember() when none is given.
+
+	Arithmetic types and strings use StaticValue. Vectors and deques use
+	StaticArray with the default schema of their elements.
+*/
+template <typename T>
+struct DefaultSchema
+{
+	using type = StaticValue<T>;
+};
+
+template <typename T, typename A>
+struct DefaultSchema<std::vector<T, A>>
+{
+	using type = StaticArray<typename DefaultSchema<T>::type>;
+};
+
+template <typename T, typename A>
+struct DefaultSchema<std::deque<T, A>>
+{
+	using type = StaticArray<typename DefaultSchema<T>::type>;
+};
+
+template <std::size_t n, typename Host, typename T, typename Schema>
+StaticMember<Host, T, Schema> MakeMember(const char (&key)[n], T Host::*mem, const Schema& schema)
+{
+	return StaticMember<Host, T, Schema>{key, n-1, mem, schema};
+}
+
+template <std::size_t n, typename Host, typename T>
+StaticMember<Host, T, typename DefaultSchema<T>::type> MakeMember(const char (&key)[n], T Host::*mem)
+{
+	return MakeMember(key, mem, typename DefaultSchema<T>::type{});
+}
+
+template <typename Host, typename... Members>
+StaticObject<Host, Members...> MakeObject(const Members&... members)
+{
+	return StaticObject<Host, Members...>{std::make_tuple(members...)};
+}
+
+template <typename ElemSchema>
+StaticArray<ElemSchema> MakeArray(const ElemSchema& elem)
+{
+	return StaticArray<ElemSchema>{elem};
+}
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,274 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "StaticParser.hh"
+#include "Exception.hh"
+
+#include <algorithm>
+#include <cassert>
+
+namespace json {
+
+namespace
+{
+	bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	bool IsHex(char c)
+	{
+		return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+	}
+}
+
+StaticReader::StaticReader(const char *data, std::size_t len, std::size_t depth) :
+	m_begin(data),
+	m_pos(data),
+	m_end(data + len),
+	m_depth(0),
+	m_max_depth(depth)
+{
+	assert(data || len == 0);
+}
+
+void StaticReader::Assign(std::string& target, Text text, bool escaped)
+{
+	if (escaped)
+		target = Unescape(text.begin(), text.size());
+
+	// reuse the capacity of the target
+	else
+		target.assign(text.begin(), text.size());
+}
+
+void StaticReader::SkipSpace()
+{
+	while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t'))
+		++m_pos;
+}
+
+/**	Starts reading an object or array.
+
+	\return	false if the next value is not the expected container. The value
+			will be skipped in this case.
+*/
+bool StaticReader::Enter(char open)
+{
+	SkipSpace();
+	if (m_pos == m_end || *m_pos != open)
+	{
+		Skip();
+		return false;
+	}
+
+	if (++m_depth > m_max_depth)
+		Error();
+
+	++m_pos;
+	return true;
+}
+
+/// Finishes reading the object or array if it ends here.
+bool StaticReader::Leave(char close)
+{
+	SkipSpace();
+	if (m_pos != m_end && *m_pos == close)
+	{
+		++m_pos;
+		--m_depth;
+		return true;
+	}
+	return false;
+}
+
+/// Consumes the separator after a value of the object or array.
+/// \return	false if it is the end of the object or array.
+bool StaticReader::Separator(char close)
+{
+	SkipSpace();
+	if (m_pos != m_end && *m_pos == ',')
+	{
+		++m_pos;
+		return true;
+	}
+	if (!Leave(close))
+		Error();
+	return false;
+}
+
+StaticReader::Text StaticReader::ObjectKey()
+{
+	SkipSpace();
+	bool escaped = false;
+	Text key = String(escaped);
+
+	SkipSpace();
+	if (m_pos == m_end || *m_pos != ':')
+		Error();
+	++m_pos;
+
+	return key;
+}
+
+/**	Reads a string, number, boolean or null.
+
+	\param	text	The text of the value. It is empty and null for the null literal.
+	\return	false if the value is an object or array, which will be skipped.
+*/
+bool StaticReader::Scalar(Text& text, bool& escaped)
+{
+	SkipSpace();
+	if (m_pos == m_end)
+		Error();
+
+	const char *start = m_pos;
+	switch (*m_pos)
+	{
+		case '"':	text = String(escaped);	return true;
+		case 't':	Literal("true", 4);		text = Text{start, m_pos};	return true;
+		case 'f':	Literal("false", 5);	text = Text{start, m_pos};	return true;
+		case 'n':	Literal("null", 4);		text = Text{nullptr, nullptr};	return true;
+		case '{':
+		case '[':	Skip();	return false;
+		default:	text = Number();	return true;
+	}
+}
+
+StaticReader::Text StaticReader::String(bool& escaped)
+{
+	if (m_pos == m_end || *m_pos != '"')
+		Error();
+
+	const char *start = ++m_pos;
+	while (m_pos != m_end && *m_pos != '"')
+	{
+		if (static_cast<unsigned char>(*m_pos) < 0x20)
+			Error();
+
+		if (*m_pos == '\\')
+		{
+			escaped = true;
+			static const char escapes[] = "\"\\/bfnrtu";
+			if (++m_pos == m_end || !std::memchr(escapes, *m_pos, sizeof(escapes)-1))
+				Error();
+
+			if (*m_pos == 'u')
+			{
+				if (m_end - m_pos < 5 || !std::all_of(m_pos+1, m_pos+5, &IsHex))
+					Error();
+				m_pos += 4;
+			}
+		}
+		++m_pos;
+	}
+	if (m_pos == m_end)
+		Error();
+
+	return Text{start, m_pos++};
+}
+
+StaticReader::Text StaticReader::Number()
+{
+	const char *start = m_pos;
+
+	if (m_pos != m_end && *m_pos == '-')
+		++m_pos;
+
+	// integer part: no leading zero
+	if (m_pos == m_end || !IsDigit(*m_pos))
+		Error();
+	if (*m_pos++ != '0')
+		while (m_pos != m_end && IsDigit(*m_pos))
+			++m_pos;
+
+	// fraction
+	if (m_pos != m_end && *m_pos == '.')
+	{
+		if (++m_pos == m_end || !IsDigit(*m_pos))
+			Error();
+		while (m_pos != m_end && IsDigit(*m_pos))
+			++m_pos;
+	}
+
+	// exponent
+	if (m_pos != m_end && (*m_pos == 'e' || *m_pos == 'E'))
+	{
+		if (++m_pos != m_end && (*m_pos == '+' || *m_pos == '-'))
+			++m_pos;
+		if (m_pos == m_end || !IsDigit(*m_pos))
+			Error();
+		while (m_pos != m_end && IsDigit(*m_pos))
+			++m_pos;
+	}
+
+	return Text{start, m_pos};
+}
+
+void StaticReader::Literal(const char *lit, std::size_t len)
+{
+	if (static_cast<std::size_t>(m_end - m_pos) < len || std::memcmp(m_pos, lit, len) != 0)
+		Error();
+	m_pos += len;
+}
+
+/// Validates and skips the next value.
+void StaticReader::Skip()
+{
+	SkipSpace();
+	if (m_pos == m_end)
+		Error();
+
+	if (*m_pos == '{' || *m_pos == '[')
+	{
+		char close = (*m_pos == '{') ? '}' : ']';
+		bool obj   = (*m_pos == '{');
+
+		if (++m_depth > m_max_depth)
+			Error();
+		++m_pos;
+
+		for (bool more = !Leave(close) ; more ; more = Separator(close))
+		{
+			if (obj)
+				ObjectKey();
+			Skip();
+		}
+	}
+	else
+	{
+		Text text;
+		bool escaped;
+		Scalar(text, escaped);
+	}
+}
+
+void StaticReader::Error() const
+{
+	std::size_t line = static_cast<std::size_t>(std::count(m_begin, m_pos, '\n'));
+
+	const char *line_start = m_pos;
+	while (line_start != m_begin && line_start[-1] != '\n')
+		--line_start;
+
+	throw ParseError() << LineNumInfo(line) << ColumnNumInfo(static_cast<std::size_t>(m_pos - line_start));
+}
+
+} // end of namespace
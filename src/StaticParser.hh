@@ -0,0 +1,195 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef STATICPARSER_HH_INCLUDED
+#define STATICPARSER_HH_INCLUDED
+
+#include "StaticBuilder.hh"
+#include "LexicalCast.hh"
+#include "Range.hh"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace json {
+
+/**	Reads JSON values from a buffer according to a static schema.
+
+	StaticReader is a recursive descent parser. The functions that read
+	objects, arrays and values are overloaded by the schema types, so the
+	compiler can inline the whole parsing code of a schema. Values that are
+	not described by the schema are validated and skipped.
+*/
+class StaticReader
+{
+public:
+	StaticReader(const char *data, std::size_t len, std::size_t depth);
+
+	template <typename Schema, typename T>
+	void Read(const Schema& schema, T& target)
+	{
+		Value(schema, target);
+		SkipSpace();
+		if (m_pos != m_end)
+			Error();
+	}
+
+private:
+	using Text = Range<const char*>;
+
+	template <typename T>
+	void Value(const StaticValue<T>&, T& target)
+	{
+		Text text;
+		bool escaped = false;
+		if (Scalar(text, escaped))
+			Assign(target, text, escaped);
+	}
+
+	template <typename ElemSchema, typename Container>
+	void Value(const StaticArray<ElemSchema>& schema, Container& target)
+	{
+		if (!Enter('['))
+			return;
+
+		for (bool more = !Leave(']') ; more ; more = Separator(']'))
+		{
+			target.emplace_back();
+			Value(schema.elem, target.back());
+		}
+	}
+
+	template <typename Host, typename... Members>
+	void Value(const StaticObject<Host, Members...>& schema, Host& target)
+	{
+		if (!Enter('{'))
+			return;
+
+		for (bool more = !Leave('}') ; more ; more = Separator('}'))
+		{
+			Text key = ObjectKey();
+			if (!Member<0>(schema.members, key, target))
+				Skip();
+		}
+	}
+
+	template <std::size_t i, typename Host, typename... Members>
+	typename std::enable_if<(i < sizeof...(Members)), bool>::type
+	Member(const std::tuple<Members...>& members, Text key, Host& target)
+	{
+		const auto& m = std::get<i>(members);
+		if (key.size() == m.len && std::memcmp(key.begin(), m.key, m.len) == 0)
+		{
+			Value(m.schema, target.*m.mem);
+			return true;
+		}
+		return Member<i+1>(members, key, target);
+	}
+
+	template <std::size_t i, typename Host, typename... Members>
+	typename std::enable_if<(i == sizeof...(Members)), bool>::type
+	Member(const std::tuple<Members...>&, Text, Host&)
+	{
+		return false;
+	}
+
+	template <typename T>
+	static void Assign(T& target, Text text, bool escaped)
+	{
+		if (escaped)
+		{
+			std::string tmp = Unescape(text.begin(), text.size());
+			target = LexicalCast<T>(tmp.data(), tmp.size());
+		}
+		else
+			LexicalAssign(target, text.begin(), text.size());
+	}
+
+	static void Assign(std::string& target, Text text, bool escaped);
+	
+	// views are not unescaped because they refer to the input
+	static void Assign(StringView& target, Text text, bool)
+	{
+		target = text;
+	}
+
+	// tokens
+	void SkipSpace();
+	bool Enter(char open);
+	bool Leave(char close);
+	bool Separator(char close);
+	Text ObjectKey();
+	bool Scalar(Text& text, bool& escaped);
+	Text String(bool& escaped);
+	Text Number();
+	void Literal(const char *lit, std::size_t len);
+	void Skip();
+
+	[[noreturn]] void Error() const;
+
+private:
+	const char	*m_begin;
+	const char	*m_pos;
+	const char	*m_end;
+
+	std::size_t	m_depth;
+	std::size_t	m_max_depth;
+};
+
+/**	Parses JSON with a static schema.
+
+	StaticParser is instantiated for the type of its schema, which describes
+	the whole object tree to be built (see StaticBuilder.hh). Unlike JsonParser,
+	it parses a complete JSON document in one go.
+*/
+template <typename Schema>
+class StaticParser
+{
+public :
+	explicit StaticParser(const Schema& schema, std::size_t depth = 10) :
+		m_schema(schema),
+		m_depth(depth)
+	{
+	}
+
+	template <typename Target>
+	void Parse(const char *data, std::size_t len, Target *target)
+	{
+		StaticReader reader(data, len, m_depth);
+		reader.Read(m_schema, *target);
+	}
+
+private :
+	Schema		m_schema;
+	std::size_t	m_depth;
+};
+
+template <typename Schema>
+StaticParser<Schema> MakeStaticParser(const Schema& schema, std::size_t depth = 10)
+{
+	return StaticParser<Schema>(schema, depth);
+}
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,106 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef STRINGVIEW_HH_INCLUDED
+#define STRINGVIEW_HH_INCLUDED
+
+#include "Range.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace json {
+
+/**	A string that refers to characters owned by someone else.
+
+	StringView is used for members that refer to the JSON text without copying
+	it, and for strings stored in a JVar. It is only valid as long as the
+	characters it refers to.
+	
+	A StringView member refers to the escaped text of the JSON, and Serialize()
+	writes it back between quotes without escaping it again. A StringView
+	member set from C++ must therefore hold escaped JSON text, e.g. \" instead
+	of a quote.
+*/
+class StringView : public Range<const char*>
+{
+public:
+	StringView() : Range(nullptr, nullptr) {}
+	StringView(const char *begin, const char *end) : Range(begin, end) {}
+	StringView(const Range<const char*>& range) : Range(range) {}
+	
+	const char* data() const	{ return begin(); }
+	bool empty() const			{ return begin() == end(); }
+	std::string Str() const		{ return std::string(begin(), end()); }
+	
+	int Compare(const char *str, std::size_t len) const
+	{
+		std::size_t n = std::min(size(), len);
+		int r = n > 0 ? std::memcmp(data(), str, n) : 0;
+		return r != 0 ? r : (size() < len ? -1 : (size() > len ? 1 : 0));
+	}
+};
+
+inline bool operator==(const StringView& s1, const StringView& s2)
+{
+	return s1.Compare(s2.data(), s2.size()) == 0;
+}
+
+inline bool operator==(const StringView& s1, const char *s2)
+{
+	return s1.Compare(s2, std::strlen(s2)) == 0;
+}
+
+inline bool operator==(const char *s1, const StringView& s2)
+{
+	return s2 == s1;
+}
+
+inline bool operator==(const StringView& s1, const std::string& s2)
+{
+	return s1.Compare(s2.data(), s2.size()) == 0;
+}
+
+inline bool operator==(const std::string& s1, const StringView& s2)
+{
+	return s2 == s1;
+}
+
+template <typename T>
+bool operator!=(const StringView& s1, const T& s2)
+{
+	return !(s1 == s2);
+}
+
+inline bool operator<(const StringView& s1, const StringView& s2)
+{
+	return s1.Compare(s2.data(), s2.size()) < 0;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const StringView& s)
+{
+	return os.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+} // end of namespace
+
+#endif
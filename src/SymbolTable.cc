@@ -0,0 +1,191 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "SymbolTable.hh"
+#include "KeyTable.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+namespace json {
+
+namespace
+{
+	// finds the block of an ID and its position in the block
+	void Locate(std::size_t id, std::size_t first, std::size_t& block, std::size_t& pos)
+	{
+		// block b starts at first * (2^b - 1)
+		block = 0;
+		for (std::size_t n = id / first + 1 ; n > 1 ; n >>= 1)
+			++block;
+		pos = id - first * ((std::size_t{1} << block) - 1);
+	}
+}
+
+const std::uint32_t SymbolTable::npos;
+const std::size_t SymbolTable::first_block;
+const std::size_t SymbolTable::max_blocks;
+
+SymbolTable::SymbolTable(std::size_t limit) :
+	m_blocks(),
+	m_index(nullptr),
+	m_size(0),
+	m_limit(std::min<std::size_t>(limit, first_block * ((std::size_t{1} << max_blocks) - 1)))
+{
+}
+
+/**	Adds a string to the table.
+
+	\return	The ID of the string. If the string is already in the table, its
+			existing ID is returned. If the table is full, npos is returned.
+*/
+std::uint32_t SymbolTable::Intern(const char *str, std::size_t len)
+{
+	assert(str || len == 0);
+	
+	std::uint64_t hash = KeyTable::Hash(str, len, 0);
+	std::uint32_t id   = Find(str, len, hash);
+	if (id != npos)
+		return id;
+	
+	// look up again in case another thread added it before the lock
+	std::lock_guard<std::mutex> lock(m_mutex);
+	id = Find(str, len, hash);
+	if (id != npos || m_size >= m_limit)
+		return id;
+	
+	id = m_size.load(std::memory_order_relaxed);
+	std::size_t block, pos;
+	Locate(id, first_block, block, pos);
+	if (pos == 0)
+		m_blocks[block] = static_cast<Symbol*>(m_arena.Allocate(sizeof(Symbol) * (first_block << block), alignof(Symbol)));
+	
+	char *name = static_cast<char*>(m_arena.Allocate(len + 1, 1));
+	std::memcpy(name, str, len);
+	name[len] = '\0';
+	m_blocks[block][pos] = Symbol{name, len, hash};
+	
+	// keep the index at most half full. The old index is still used by readers,
+	// so it stays in the arena.
+	Index *index = m_index.load(std::memory_order_relaxed);
+	if (!index || (index->mask + 1) < (id + 1) * 2)
+	{
+		Index *grown = NewIndex(index ? (index->mask + 1) * 2 : 64);
+		for (std::uint32_t i = 0 ; i <= id ; ++i)
+			Insert(grown, i, At(i).hash);
+		m_index.store(grown, std::memory_order_release);
+	}
+	else
+		Insert(index, id, hash);
+	
+	m_size.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+/**	Looks up a string without adding it.
+
+	\return	The ID of the string, or npos if it is not in the table.
+*/
+std::uint32_t SymbolTable::Find(const char *str, std::size_t len) const
+{
+	return Find(str, len, KeyTable::Hash(str, len, 0));
+}
+
+std::uint32_t SymbolTable::Find(const char *str, std::size_t len, std::uint64_t hash) const
+{
+	const Index *index = m_index.load(std::memory_order_acquire);
+	if (!index)
+		return npos;
+	
+	for (std::size_t slot = hash & index->mask ; ; slot = (slot + 1) & index->mask)
+	{
+		// the symbol is written before its slot
+		std::uint32_t entry = index->slots[slot].load(std::memory_order_acquire);
+		if (entry == 0)
+			return npos;
+		
+		const Symbol& sym = At(entry - 1);
+		if (sym.hash == hash && sym.len == len && std::memcmp(sym.str, str, len) == 0)
+			return entry - 1;
+	}
+}
+
+SymbolTable::Index* SymbolTable::NewIndex(std::size_t size)
+{
+	void *p = m_arena.Allocate(offsetof(Index, slots) + size * sizeof(std::atomic<std::uint32_t>), alignof(Index));
+	
+	Index *index = static_cast<Index*>(p);
+	index->mask = size - 1;
+	for (std::size_t i = 0 ; i < size ; ++i)
+		::new(&index->slots[i]) std::atomic<std::uint32_t>(0);
+	return index;
+}
+
+void SymbolTable::Insert(Index *index, std::uint32_t id, std::uint64_t hash)
+{
+	std::size_t slot = hash & index->mask;
+	while (index->slots[slot].load(std::memory_order_relaxed) != 0)
+		slot = (slot + 1) & index->mask;
+	
+	index->slots[slot].store(id + 1, std::memory_order_release);
+}
+
+const SymbolTable::Symbol& SymbolTable::At(std::uint32_t id) const
+{
+	
+	std::size_t block, pos;
+	Locate(id, first_block, block, pos);
+	return m_blocks[block][pos];
+}
+
+/**	Returns the string of an ID. It is valid until the table is destroyed, and
+	is followed by a null character.
+*/
+StringView SymbolTable::Name(std::uint32_t id) const
+{
+	const Symbol& sym = At(id);
+	return StringView{sym.str, sym.str + sym.len};
+}
+
+/**	Returns the hash of the string of an ID, which is the same as the one
+	calculated by KeyTable::Hash() with a zero seed.
+*/
+std::uint64_t SymbolTable::Hash(std::uint32_t id) const
+{
+	return At(id).hash;
+}
+
+std::size_t SymbolTable::Size() const
+{
+	return m_size;
+}
+
+/**	The table used by Key and JVar.
+*/
+SymbolTable& SymbolTable::Global()
+{
+	static SymbolTable table;
+	return table;
+}
+
+} // end of namespace
@@ -0,0 +1,104 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef SYMBOLTABLE_HH_INCLUDED
+#define SYMBOLTABLE_HH_INCLUDED
+
+#include "Arena.hh"
+#include "StringView.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace json {
+
+/**	Interns strings to small integer IDs.
+
+	Each distinct string added by Intern() gets an ID, starting from zero. The
+	strings are stored in the table until it is destroyed, so the names of the
+	IDs can be used without copying them. Two keys interned by the same table
+	are equal if their IDs are equal.
+	
+	SymbolTable::Global() is shared by json::Key and the hashes of JVar. It lets
+	documents parsed at different times share the storage of their keys.
+	Because interned strings are never freed, only keys from a bounded set
+	should be interned. The table stops adding strings after its limit is
+	reached, and Intern() then returns npos.
+	
+	All functions are thread-safe. Looking up a string that is already in the
+	table does not take a lock. Only adding a new string does.
+*/
+class SymbolTable
+{
+public:
+	static const std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+public:
+	explicit SymbolTable(std::size_t limit = 1 << 20);
+	SymbolTable(const SymbolTable&) = delete;
+	SymbolTable& operator=(const SymbolTable&) = delete;
+	
+	std::uint32_t Intern(const char *str, std::size_t len);
+	std::uint32_t Find(const char *str, std::size_t len) const;
+	
+	StringView Name(std::uint32_t id) const;
+	std::uint64_t Hash(std::uint32_t id) const;
+	std::size_t Size() const;
+	
+	static SymbolTable& Global();
+	
+private:
+	struct Symbol
+	{
+		const char		*str;
+		std::size_t		len;
+		std::uint64_t	hash;	//!< KeyTable::Hash() of the string with seed 0
+	};
+	
+	//! Open addressing table of IDs plus one, or zero for empty slots.
+	struct Index
+	{
+		std::size_t					mask;
+		std::atomic<std::uint32_t>	slots[1];
+	};
+	
+	// symbols are stored in blocks that double in size, so they never move
+	static const std::size_t first_block	= 256;
+	static const std::size_t max_blocks		= 24;
+	
+	const Symbol& At(std::uint32_t id) const;
+	std::uint32_t Find(const char *str, std::size_t len, std::uint64_t hash) const;
+	Index* NewIndex(std::size_t size);
+	static void Insert(Index *index, std::uint32_t id, std::uint64_t hash);
+	
+private:
+	std::mutex					m_mutex;				//!< taken to add symbols
+	Arena						m_arena;				//!< strings, blocks and indices
+	Symbol						*m_blocks[max_blocks];
+	std::atomic<Index*>			m_index;
+	std::atomic<std::uint32_t>	m_size;
+	std::size_t					m_limit;
+};
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,365 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Tape.hh"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace json {
+
+const unsigned Tape::type_shift;
+const std::uint64_t Tape::payload;
+const std::uint8_t Tape::end_tag;
+
+TapeView::TapeView(const Tape *tape, std::size_t pos) :
+	m_tape(tape),
+	m_pos(pos)
+{
+	assert(m_tape);
+}
+
+// the value past the end of the tape is null, so an empty tape has a null root
+std::uint64_t TapeView::Word() const
+{
+	return m_pos < m_tape->m_words.size() ?
+		m_tape->m_words[m_pos] :
+		Tape::MakeWord(static_cast<std::uint8_t>(json::Type::null), 0);
+}
+
+json::Type TapeView::Type() const
+{
+	return static_cast<json::Type>(Tape::Tag(Word()));
+}
+
+bool TapeView::Is(json::Type type) const
+{
+	return Type() == type;
+}
+
+bool TapeView::IsNull() const
+{
+	return Is(json::Type::null);
+}
+
+long long TapeView::Long() const
+{
+	if (Type() != json::Type::integer)
+		throw -1;
+	
+	return static_cast<long long>(m_tape->m_words[m_pos + 1]);
+}
+
+double TapeView::Real() const
+{
+	if (Type() != json::Type::real)
+		throw -1;
+	
+	double val;
+	std::memcpy(&val, &m_tape->m_words[m_pos + 1], sizeof(val));
+	return val;
+}
+
+bool TapeView::Bool() const
+{
+	if (Type() != json::Type::boolean)
+		throw -1;
+	
+	return Tape::Payload(Word()) != 0;
+}
+
+StringView TapeView::Str() const
+{
+	if (Type() != json::Type::string)
+		throw -1;
+	
+	return m_tape->String(m_pos);
+}
+
+/**	Returns the number of elements of an array or object, or zero for other
+	values. It reads the end of the container without visiting the elements.
+*/
+std::size_t TapeView::Size() const
+{
+	if (!Is(json::Type::array) && !Is(json::Type::hash))
+		return 0;
+	
+	return static_cast<std::size_t>(Tape::Payload(m_tape->m_words[Tape::Payload(Word()) - 1]));
+}
+
+/**	Returns an element of an array. The elements before it are skipped in
+	constant time each.
+	
+	\throw	int					If the value is not an array.
+	\throw	std::out_of_range	If idx is not less than Size().
+*/
+TapeView TapeView::operator[](std::size_t idx) const
+{
+	if (Type() != json::Type::array)
+		throw -1;
+	if (idx >= Size())
+		throw std::out_of_range("TapeView");
+	
+	auto it = begin();
+	while (idx-- > 0)
+		++it;
+	return *it;
+}
+
+/**	Returns the value of a member of an object.
+
+	\throw	int	If the value is not an object or the key is not found.
+*/
+TapeView TapeView::operator[](const std::string& key) const
+{
+	auto it = Find(StringView{key.data(), key.data() + key.size()});
+	if (it == end())
+		throw -1;
+	
+	return *it;
+}
+
+/**	Looks up a member of an object by comparing the keys one by one.
+
+	\return	The iterator to the member, or end() if it is not found.
+	\throw	int	If the value is not an object.
+*/
+TapeView::Iterator TapeView::Find(const StringView& key) const
+{
+	if (Type() != json::Type::hash)
+		throw -1;
+	
+	auto it = begin();
+	while (it != end() && it.Key() != key)
+		++it;
+	return it;
+}
+
+/**	Returns the first element of an array or object. Other values have no
+	elements.
+*/
+TapeView::Iterator TapeView::begin() const
+{
+	bool container = Is(json::Type::array) || Is(json::Type::hash);
+	return Iterator{m_tape, container ? m_pos + 1 : m_pos, Is(json::Type::hash)};
+}
+
+TapeView::Iterator TapeView::end() const
+{
+	bool container = Is(json::Type::array) || Is(json::Type::hash);
+	return Iterator{m_tape, container ? static_cast<std::size_t>(Tape::Payload(Word())) - 1 : m_pos, Is(json::Type::hash)};
+}
+
+TapeView::Iterator::Iterator(const Tape *tape, std::size_t pos, bool object) :
+	m_tape(tape),
+	m_pos(pos),
+	m_object(object)
+{
+}
+
+TapeView TapeView::Iterator::operator*() const
+{
+	return TapeView{m_tape, m_object ? m_pos + 1 : m_pos};
+}
+
+/// Returns the key of an object member, or an empty string for array elements.
+StringView TapeView::Iterator::Key() const
+{
+	return m_object ? m_tape->String(m_pos) : StringView{};
+}
+
+TapeView::Iterator& TapeView::Iterator::operator++()
+{
+	if (m_object)
+		m_pos = m_tape->Next(m_pos);
+	
+	m_pos = m_tape->Next(m_pos);
+	return *this;
+}
+
+TapeView::Iterator TapeView::Iterator::operator++(int)
+{
+	Iterator it = *this;
+	++*this;
+	return it;
+}
+
+Tape::Tape()
+{
+}
+
+TapeView Tape::Root() const
+{
+	return TapeView{this, 0};
+}
+
+/// Number of words in the tape.
+std::size_t Tape::Words() const
+{
+	return m_words.size();
+}
+
+bool Tape::Empty() const
+{
+	return m_words.empty();
+}
+
+/**	Removes the document but keeps the memory for the next one.
+*/
+void Tape::Clear()
+{
+	m_words.clear();
+	m_strings.clear();
+	m_open.clear();
+}
+
+std::uint64_t Tape::MakeWord(std::uint8_t tag, std::uint64_t val)
+{
+	assert(val <= payload);
+	return (static_cast<std::uint64_t>(tag) << type_shift) | val;
+}
+
+std::uint8_t Tape::Tag(std::uint64_t word)
+{
+	return static_cast<std::uint8_t>(word >> type_shift);
+}
+
+std::uint64_t Tape::Payload(std::uint64_t word)
+{
+	return word & payload;
+}
+
+/**	Starts an array or object. A value outside of any container starts a new
+	document, so the tape is cleared first.
+*/
+void Tape::Open(json::Type type)
+{
+	assert(type == json::Type::array || type == json::Type::hash);
+	
+	AddElement(static_cast<std::uint8_t>(type), 0);
+	m_open.push_back(m_words.size() - 1);
+}
+
+/**	Finishes the innermost array or object.
+*/
+void Tape::Close()
+{
+	assert(!m_open.empty());
+	
+	std::size_t start = m_open.back();
+	m_open.pop_back();
+	
+	m_words.push_back(MakeWord(end_tag, Payload(m_words[start])));
+	m_words[start] = MakeWord(Tag(m_words[start]), m_words.size());
+}
+
+/**	Adds the key of the next member of an object.
+*/
+void Tape::AddKey(const char *str, std::size_t len)
+{
+	assert(!m_open.empty() && Tag(m_words[m_open.back()]) == static_cast<std::uint8_t>(json::Type::hash));
+	
+	m_words.push_back(MakeWord(static_cast<std::uint8_t>(json::Type::string), m_strings.size()));
+	AddChars(str, len);
+}
+
+void Tape::AddString(const char *str, std::size_t len)
+{
+	AddElement(static_cast<std::uint8_t>(json::Type::string), m_strings.size());
+	AddChars(str, len);
+}
+
+void Tape::AddInteger(long long val)
+{
+	AddElement(static_cast<std::uint8_t>(json::Type::integer), 0);
+	m_words.push_back(static_cast<std::uint64_t>(val));
+}
+
+void Tape::AddReal(double val)
+{
+	std::uint64_t bits;
+	std::memcpy(&bits, &val, sizeof(bits));
+	
+	AddElement(static_cast<std::uint8_t>(json::Type::real), 0);
+	m_words.push_back(bits);
+}
+
+void Tape::AddBool(bool val)
+{
+	AddElement(static_cast<std::uint8_t>(json::Type::boolean), val ? 1 : 0);
+}
+
+void Tape::AddNull()
+{
+	AddElement(static_cast<std::uint8_t>(json::Type::null), 0);
+}
+
+// adds a value to the innermost container, which counts its elements
+void Tape::AddElement(std::uint8_t tag, std::uint64_t val)
+{
+	if (m_open.empty())
+		Clear();
+	else
+		++m_words[m_open.back()];
+	
+	m_words.push_back(MakeWord(tag, val));
+}
+
+// strings are stored with a 32-bit length before and a null after them
+void Tape::AddChars(const char *str, std::size_t len)
+{
+	if (len > UINT32_MAX)
+		throw std::length_error("Tape");
+	
+	auto size = static_cast<std::uint32_t>(len);
+	const char *prefix = reinterpret_cast<const char*>(&size);
+	
+	m_strings.insert(m_strings.end(), prefix, prefix + sizeof(size));
+	m_strings.insert(m_strings.end(), str, str + len);
+	m_strings.push_back('\0');
+}
+
+/// Returns the position of the value after the one at pos.
+std::size_t Tape::Next(std::size_t pos) const
+{
+	std::uint64_t word = m_words[pos];
+	switch (static_cast<json::Type>(Tag(word)))
+	{
+	case json::Type::array:
+	case json::Type::hash:		return static_cast<std::size_t>(Payload(word));
+	case json::Type::integer:
+	case json::Type::real:		return pos + 2;
+	default:					return pos + 1;
+	}
+}
+
+StringView Tape::String(std::size_t pos) const
+{
+	std::size_t offset = static_cast<std::size_t>(Payload(m_words[pos]));
+	
+	std::uint32_t size;
+	std::memcpy(&size, &m_strings[offset], sizeof(size));
+	
+	const char *str = &m_strings[offset + sizeof(size)];
+	return StringView{str, str + size};
+}
+
+} // end of namespace
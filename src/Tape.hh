@@ -0,0 +1,179 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef TAPE_HH_INCLUDED
+#define TAPE_HH_INCLUDED
+
+#include "StringView.hh"
+#include "Type.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace json {
+
+class Tape;
+
+/**	A read-only reference to a value in a Tape.
+
+	TapeView has accessors like JVar, and throws the same way when the value
+	is not of the type asked for. It is only valid as long as the Tape.
+*/
+class TapeView
+{
+public:
+	class Iterator;
+
+public:
+	TapeView(const Tape *tape, std::size_t pos);
+	
+	json::Type Type() const;
+	bool Is(json::Type type) const;
+	bool IsNull() const;
+	
+	int Int() const					{return static_cast<int>(Long());}
+	long long Long() const;
+	double Real() const;
+	bool Bool() const;
+	StringView Str() const;
+	
+	std::size_t Size() const;
+	TapeView operator[](std::size_t idx) const;
+	TapeView operator[](const std::string& key) const;
+	Iterator Find(const StringView& key) const;
+	
+	Iterator begin() const;
+	Iterator end() const;
+	
+private:
+	std::uint64_t Word() const;
+	
+private:
+	const Tape	*m_tape;
+	std::size_t	m_pos;
+};
+
+/**	Iterates the elements of an array or the members of an object in a Tape.
+
+	Moving to the next element skips the whole current element in constant time.
+*/
+class TapeView::Iterator
+{
+public:
+	using iterator_category	= std::forward_iterator_tag;
+	using value_type		= TapeView;
+	using difference_type	= std::ptrdiff_t;
+	using pointer			= const TapeView*;
+	using reference			= TapeView;
+
+public:
+	Iterator(const Tape *tape, std::size_t pos, bool object);
+	
+	TapeView operator*() const;
+	StringView Key() const;
+	Iterator& operator++();
+	Iterator operator++(int);
+	
+	bool operator==(const Iterator& it) const	{return m_pos == it.m_pos;}
+	bool operator!=(const Iterator& it) const	{return m_pos != it.m_pos;}
+
+private:
+	const Tape	*m_tape;
+	std::size_t	m_pos;		//!< the key of a member, or an element
+	bool		m_object;
+};
+
+/**	A read-only document stored in one array of 64-bit words.
+
+	Each value takes one word on the tape: an 8-bit type followed by a 56-bit
+	payload. Integers and doubles take one more word for their values. Strings
+	are stored in a separate buffer, prefixed by their lengths, and the word
+	refers to them by offset. The members of an object are a key string
+	followed by the value.
+	
+	An array or object takes two words: one at its start, which stores the
+	position after its end, and one at its end, which stores the number of
+	elements. A TapeView can therefore skip any value or find the size of any
+	container in constant time.
+	
+	Unlike JVar, the whole document takes two allocations, one for the tape
+	and one for the strings. Parsing again into the same Tape reuses them.
+	Use TapeBuilder to build a Tape with JsonParser.
+	
+	\code{.cpp}
+	Tape tape;
+	TapeBuilder h;
+	JsonParser parser(&h);
+	parser.Parse(json, len, &tape);
+	std::cout << tape.Root()["items"][0]["id"].Str();
+	\endcode
+*/
+class Tape
+{
+public:
+	Tape();
+	
+	TapeView Root() const;
+	std::size_t Words() const;
+	bool Empty() const;
+	void Clear();
+	
+	// building the tape in document order
+	void Open(json::Type type);
+	void Close();
+	void AddKey(const char *str, std::size_t len);
+	void AddString(const char *str, std::size_t len);
+	void AddInteger(long long val);
+	void AddReal(double val);
+	void AddBool(bool val);
+	void AddNull();
+	
+private:
+	friend class TapeView;
+	friend class TapeView::Iterator;
+	
+	static const unsigned			type_shift	= 56;
+	static const std::uint64_t		payload		= (std::uint64_t{1} << type_shift) - 1;
+	static const std::uint8_t		end_tag		= 0xFF;
+	
+	static std::uint64_t MakeWord(std::uint8_t tag, std::uint64_t val);
+	static std::uint8_t Tag(std::uint64_t word);
+	static std::uint64_t Payload(std::uint64_t word);
+	
+	void AddElement(std::uint8_t tag, std::uint64_t val);
+	void AddChars(const char *str, std::size_t len);
+	std::size_t Next(std::size_t pos) const;
+	StringView String(std::size_t pos) const;
+	
+private:
+	std::vector<std::uint64_t>	m_words;
+	std::vector<char>			m_strings;
+	
+	//! positions of the containers being built. Their start words store the
+	//! number of elements added so far.
+	std::vector<std::size_t>	m_open;
+};
+
+} // end of namespace
+
+#endif
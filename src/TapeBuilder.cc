@@ -0,0 +1,140 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "TapeBuilder.hh"
+#include "JVarBuilder.hh"
+
+#include <cassert>
+#include <cstring>
+#include <string>
+
+namespace json {
+
+void TapeBuilder::Data(const Cursor& current, JSON_event type, const char *data, size_t len) const
+{
+	assert(this->Check(current));
+	
+	AddKey(current);
+	auto tape = current.Target<Tape>();
+	switch (type)
+	{
+	case JSON_string:
+		if (data && std::memchr(data, '\\', len))
+		{
+			std::string str = Unescape(data, len);
+			tape->AddString(str.data(), str.size());
+		}
+		else
+			tape->AddString(data, data ? len : 0);
+		break;
+	
+	case JSON_number:
+	{
+		JVar num = JVarBuilder::Scalar(type, data, len);
+		if (num.Is(Type::integer))
+			tape->AddInteger(num.Long());
+		else
+			tape->AddReal(num.Real());
+		break;
+	}
+	
+	case JSON_true:		tape->AddBool(true);	break;
+	case JSON_false:	tape->AddBool(false);	break;
+	default:			tape->AddNull();		break;
+	}
+}
+
+Cursor TapeBuilder::Advance(const Cursor& current) const
+{
+	assert(this->Check(current));
+	
+	AddKey(current);
+	return Cursor{current.Key(), current.Target<Tape>(), this};
+}
+
+void TapeBuilder::Start(const Cursor& current, JSON_event type) const
+{
+	assert(this->Check(current));
+	current.Target<Tape>()->Open(type == JSON_object_start ? Type::hash : Type::array);
+}
+
+void TapeBuilder::Finish(const Cursor& current) const
+{
+	assert(this->Check(current));
+	current.Target<Tape>()->Close();
+}
+
+void TapeBuilder::Write(const Cursor& current, Writer& out) const
+{
+	assert(this->Check(current));
+	WriteValue(current.Target<Tape>()->Root(), out);
+}
+
+// the strings and keys in a tape are unescaped, so they are escaped again
+void TapeBuilder::WriteValue(const TapeView& value, Writer& out)
+{
+	switch (value.Type())
+	{
+	case Type::integer:	out.Int(value.Long());		break;
+	case Type::real:	out.Real(value.Real());		break;
+	case Type::boolean:	out.Bool(value.Bool());		break;
+	case Type::string:	out.String(value.Str());	break;
+	
+	case Type::array:
+	case Type::hash:
+	{
+		bool object = value.Is(Type::hash);
+		out.Raw(object ? '{' : '[');
+		for (auto it = value.begin() ; it != value.end() ; ++it)
+		{
+			if (it != value.begin())
+				out.Raw(',');
+			if (object)
+			{
+				out.String(it.Key());
+				out.Raw(':');
+			}
+			WriteValue(*it, out);
+		}
+		out.Raw(object ? '}' : ']');
+		break;
+	}
+	
+	default:	out.Null();	break;
+	}
+}
+
+// adds the key before the value of an object member
+void TapeBuilder::AddKey(const Cursor& current)
+{
+	if (!current.Key().IsKey())
+		return;
+	
+	auto key = current.Key().Data();
+	if (key.size() > 0 && std::memchr(key.begin(), '\\', key.size()))
+	{
+		std::string str = Unescape(key.begin(), key.size());
+		current.Target<Tape>()->AddKey(str.data(), str.size());
+	}
+	else
+		current.Target<Tape>()->AddKey(key.begin(), key.size());
+}
+
+} // end of namespace
@@ -0,0 +1,52 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef TAPEBUILDER_HH_INCLUDED
+#define TAPEBUILDER_HH_INCLUDED
+
+#include "TypeBuilder.hh"
+#include "Tape.hh"
+
+namespace json {
+
+/**	Builds a Tape from any JSON document.
+
+	The values are added to the tape in the order they are parsed. Numbers are
+	converted like JVarBuilder does, and strings and keys are unescaped.
+	Parsing into a Tape replaces the document in it. If parsing fails, call
+	Tape::Clear() before using the Tape again.
+*/
+class TapeBuilder : public TypeBuilder<Tape>
+{
+public:
+	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override;
+	Cursor Advance(const Cursor& current) const override;
+	void Start(const Cursor& current, JSON_event type) const override;
+	void Finish(const Cursor& current) const override;
+	void Write(const Cursor& current, Writer& out) const override;
+	
+private:
+	static void AddKey(const Cursor& current);
+	static void WriteValue(const TapeView& value, Writer& out);
+};
+
+} // end of namespace
+
+#endif
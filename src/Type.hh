@@ -21,6 +21,12 @@
 #ifndef TYPE_HH_INCLUDED
 #define TYPE_HH_INCLUDED
 
+#include "Arena.hh"
+#include "FlatHash.hh"
+#include "StringView.hh"
+
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -30,7 +36,13 @@ namespace json {
 
 class JVar;
 
-enum class Type { null, integer, real, boolean, string, array, hash };
+// the containers used by JVar, which may allocate from an Arena. JString is
+// the type of the keys of hashes.
+using JString	= std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+using JArray	= std::vector<JVar, ArenaAllocator<JVar>>;
+using JHash		= FlatHash<JVar, ArenaAllocator<JVar>>;
+
+enum class Type : std::uint8_t { null, integer, real, boolean, string, array, hash };
 
 // mapping from a C++ type to its corresponding JSON type
 template <typename T, typename=void> struct TypeMap;
@@ -60,42 +72,63 @@ template <>
 struct TypeMap<std::string>
 {
 	static const Type type = Type::string;
-	typedef std::string UnderlyingType ;
+	typedef StringView UnderlyingType ;
+};
+
+template <>
+struct TypeMap<StringView>
+{
+	static const Type type = Type::string;
+	typedef StringView UnderlyingType ;
+};
+
+template <>
+struct TypeMap<JString>
+{
+	static const Type type = Type::string;
+	typedef StringView UnderlyingType ;
 };
 
 template <>
 struct TypeMap<const char*>
 {
 	static const Type type = Type::string;
-	typedef std::string UnderlyingType ;
+	typedef StringView UnderlyingType ;
 };
 
 template <std::size_t n>
 struct TypeMap<char[n]>
 {
 	static const Type type = Type::string;
-	typedef std::string UnderlyingType ;
+	typedef StringView UnderlyingType ;
 };
 
 template <std::size_t n>
 struct TypeMap<const char[n]>
 {
 	static const Type type = Type::string;
-	typedef std::string UnderlyingType ;
+	typedef StringView UnderlyingType ;
 };
 
-template <typename T>
-struct TypeMap<std::vector<T>>
+template <typename T, typename A>
+struct TypeMap<std::vector<T, A>>
 {
 	static const Type type = Type::array;
-	typedef std::vector<JVar> UnderlyingType ;
+	typedef JArray UnderlyingType ;
 };
 
-template <>
-struct TypeMap<std::map<std::string, JVar>>
+template <typename K, typename C, typename A>
+struct TypeMap<std::map<K, JVar, C, A>>
+{
+	static const Type type = Type::hash;
+	typedef JHash UnderlyingType ;
+};
+
+template <typename A>
+struct TypeMap<FlatHash<JVar, A>>
 {
 	static const Type type = Type::hash;
-	typedef std::map<std::string, JVar> UnderlyingType ;
+	typedef JHash UnderlyingType ;
 };
 
 template <>
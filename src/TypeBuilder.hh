@@ -27,12 +27,108 @@
 #include "Cursor.hh"
 
 #include "LexicalCast.hh"
+#include "Writer.hh"
 
 #include <cassert>
+#include <cstring>
+#include <string>
 #include <type_traits>
 
 namespace json {
 
+namespace detail
+{
+	/**	Resets an element that is built again to a default constructed T.
+	
+		Copy assignment keeps the capacity of strings and containers in the
+		element, which moving a new element into it would free.
+	*/
+	template <typename T>
+	typename std::enable_if<std::is_copy_assignable<T>::value>::type Reset(T& elem)
+	{
+		const T blank{};
+		elem = blank;
+	}
+	
+	template <typename T>
+	typename std::enable_if<!std::is_copy_assignable<T>::value>::type Reset(T& elem)
+	{
+		elem = T{};
+	}
+	
+	/**	Returns a Cursor to write the target.
+	
+		Cursors refer to non-const targets because they are built, but Write()
+		does not modify them.
+	*/
+	template <typename T>
+	Cursor WriteCursor(const Key& key, const T& target, const JsonProcessor *rec)
+	{
+		return Cursor{key, const_cast<T*>(&target), rec};
+	}
+	
+	template <typename T>
+	void AssignScalar(T& dest, JSON_event, const char *data, std::size_t len)
+	{
+		LexicalAssign(dest, data, len);
+	}
+	
+	// true and false come without text
+	inline void AssignScalar(bool& dest, JSON_event type, const char *, std::size_t)
+	{
+		dest = (type == JSON_true);
+	}
+	
+	// the parser gives the escaped text of strings
+	inline void AssignScalar(std::string& dest, JSON_event, const char *data, std::size_t len)
+	{
+		if (data != nullptr && std::memchr(data, '\\', len))
+			dest = Unescape(data, len);
+		else
+			LexicalAssign(dest, data, len);
+	}
+	
+	// the reverse of AssignScalar()
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+	WriteScalar(Writer& out, T val)
+	{
+		out.Int(val);
+	}
+	
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+	WriteScalar(Writer& out, T val)
+	{
+		out.Uint(val);
+	}
+	
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value>::type
+	WriteScalar(Writer& out, T val)
+	{
+		out.Real(val);
+	}
+	
+	inline void WriteScalar(Writer& out, bool val)
+	{
+		out.Bool(val);
+	}
+	
+	inline void WriteScalar(Writer& out, const std::string& val)
+	{
+		out.String(val.data(), val.size());
+	}
+	
+	// StringView refers to the escaped text, so it is written as it is
+	inline void WriteScalar(Writer& out, const StringView& val)
+	{
+		out.Raw('"');
+		out.Raw(val.data(), val.size());
+		out.Raw('"');
+	}
+}
+
 class MockObjectHandler : public JsonProcessor
 {
 public:
@@ -67,6 +163,15 @@ public:
 	virtual ~TypeBuilder() = default;
 };
 
+/**	Builds a string, number or boolean by LexicalAssign().
+
+	A std::string is unescaped, and reuses its capacity when it is assigned again
+	without escape sequences. A StringView
+	refers to the input buffer without copying. Since a value that spans two
+	chunks given to JsonParser::Parse() is copied to the internal buffer of the
+	parser, a StringView is only valid when the whole value is in one chunk and
+	the buffer outlives it.
+*/
 template <typename T>
 class SimpleTypeBuilder : public TypeBuilder<T>
 {
@@ -79,10 +184,10 @@ public :
 	SimpleTypeBuilder(SimpleTypeBuilder&&) = default;
 #endif
 
-	void Data(const Cursor& current, JSON_event, const char *data, size_t len) const override
+	void Data(const Cursor& current, JSON_event type, const char *data, size_t len) const override
 	{
 		assert(this->Check(current));
-		*current.Target<T>() = LexicalCast<T>(data, len);
+		detail::AssignScalar(*current.Target<T>(), type, data, len);
 	}
 	
 	Cursor Advance(const Cursor& current) const override
@@ -95,6 +200,12 @@ public :
 	{
 		assert(this->Check(current));
 	}
+	
+	void Write(const Cursor& current, Writer& out) const override
+	{
+		assert(this->Check(current));
+		detail::WriteScalar(out, *current.Target<T>());
+	}
 };
 
 /*!	Builds a member of a class with the given builder.
@@ -137,11 +248,34 @@ public:
 		assert(this->Check(current));
 	}
 	
+	void Write(const Cursor& current, Writer& out) const override
+	{
+		assert(this->Check(current));
+		m_rec.Write(detail::WriteCursor(current.Key(), current.Target<Host>()->*m_mem, &m_rec), out);
+	}
+	
 private:
 	Builder		m_rec;
 	T Host::*	m_mem;
 };
 
+/**	Writes an object as JSON with the builder that builds it.
+
+	The members are written in the order they are added to the builders. No
+	JVar or other intermediate objects are created.
+	
+	\code{.cpp}
+	std::string json;
+	Writer out(json);
+	Serialize(book_builder, book, out);
+	\endcode
+*/
+template <typename Host>
+void Serialize(const TypeBuilder<Host>& builder, const Host& obj, Writer& out)
+{
+	builder.Write(detail::WriteCursor(Key{0}, obj, &builder), out);
+}
+
 } // end of namespace
 
 #endif
@@ -23,14 +23,46 @@
 
 #include "TypeBuilder.hh"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <iterator>
 #include <memory>
+#include <type_traits>
 
 namespace json {
 
 template <typename Host> class JsonBuilder;
+
+namespace detail
+{
+	// only containers with reserve() can be reserved
+	template <typename C>
+	auto Reserve(C& c, std::size_t n, int) -> decltype(c.reserve(n), void())
+	{
+		c.reserve(n);
+	}
 	
-// host is a vector of T
+	template <typename C>
+	void Reserve(C&, std::size_t, long)
+	{
+	}
+}
+
+/**	Builds a container of T from a JSON array by appending each element to it.
+
+	By default the elements are appended to the container. Two options reduce
+	the allocations when the same container is parsed repeatedly:
+	- The capacity hint reserves the container before the first element. The
+	  builder also remembers the size of the last array it built, and reserves
+	  that many if it is larger than the hint.
+	- In reuse mode, the N-th element of the array is built in place on the N-th
+	  existing element of the container, and the container grows only for the
+	  elements beyond its size. An existing element is reset to a default
+	  constructed T before it is built, keeping the capacity of its strings, so
+	  members missing in the JSON do not keep their old values. Elements left
+	  over from the previous parse are erased when the array ends.
+*/
 template <
 	typename T,
 	template <typename, typename> class Container=std::vector,
@@ -49,7 +81,11 @@ public:
 	~VectorBuilder() override = default;
 	
 	template <typename Builder=JsonBuilder<T>>
-	VectorBuilder(const Builder& v) : m_visitor(std::make_shared<Builder>(v))
+	VectorBuilder(const Builder& v, std::size_t capacity_hint = 0, bool reuse = false) :
+		m_visitor(std::make_shared<Builder>(v)),
+		m_hint(capacity_hint),
+		m_reuse(reuse),
+		m_learned(std::make_shared<std::atomic<std::size_t>>(0))
 	{
 		assert(m_visitor);
 		static_assert(
@@ -62,10 +98,7 @@ public:
 		assert(this->Check(current));
 		assert(m_visitor);
 
-		auto host = current.Target<HostType>();
-		host->emplace_back();
-		
-		m_visitor->Data(Cursor{current.Key(), &host->back(), m_visitor.get()}, type, data, len);
+		m_visitor->Data(Cursor{current.Key(), Element(current), m_visitor.get()}, type, data, len);
 	}
 	
 	Cursor Advance(const Cursor& current) const override
@@ -73,19 +106,71 @@ public:
 		assert(this->Check(current));
 		assert(m_visitor);
 		
-		auto host = current.Target<HostType>();
-		host->emplace_back();
-
-		return Cursor{current.Key(), &host->back(), m_visitor.get()};
+		return Cursor{current.Key(), Element(current), m_visitor.get()};
 	}
 
 	void Finish(const Cursor& current) const override
 	{
 		assert(this->Check(current));
+		
+		// the key is the number of elements at the end of an array
+		if (current.Key().IsIndex())
+		{
+			std::size_t count = current.Key().Index();
+			m_learned->store(count, std::memory_order_relaxed);
+			
+			auto host = current.Target<HostType>();
+			if (m_reuse && count < host->size())
+				host->erase(std::next(host->begin(), count), host->end());
+		}
+	}
+	
+	void Write(const Cursor& current, Writer& out) const override
+	{
+		assert(this->Check(current));
+		
+		std::size_t idx = 0;
+		out.Raw('[');
+		for (const auto& elem : *current.Target<HostType>())
+		{
+			if (idx > 0)
+				out.Raw(',');
+			m_visitor->Write(detail::WriteCursor(Key{idx++}, elem, m_visitor.get()), out);
+		}
+		out.Raw(']');
+	}
+
+private:
+	T* Element(const Cursor& current) const
+	{
+		auto host = current.Target<HostType>();
+		
+		std::size_t index = current.Key().IsIndex() ? current.Key().Index() : host->size();
+		if (index == 0)
+		{
+			std::size_t hint = std::max(m_hint, m_learned->load(std::memory_order_relaxed));
+			detail::Reserve(*host, (m_reuse ? 0 : host->size()) + hint, 0);
+		}
+		
+		if (m_reuse && index < host->size())
+		{
+			T& elem = *std::next(host->begin(), index);
+			detail::Reset(elem);
+			return &elem;
+		}
+		
+		host->emplace_back();
+		return &host->back();
 	}
 
 private:
 	std::shared_ptr<const JsonProcessor>	m_visitor;
+	
+	std::size_t	m_hint;
+	bool		m_reuse;
+	
+	//! size of the last array built, shared by the copies of the builder
+	std::shared_ptr<std::atomic<std::size_t>>	m_learned;
 };
 
 } // end of namespace
@@ -0,0 +1,710 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Writer.hh"
+#include "JVar.hh"
+#include "JsonProcessor.hh"
+#include "Cursor.hh"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace json {
+
+namespace detail {
+	// in PowerOfTen.cc
+	extern const std::uint64_t power_of_ten_126[];
+}
+
+namespace
+{
+	const char digit_pairs[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	const char hex_digits[] = "0123456789abcdef";
+
+	/*	Writes the decimal digits of val backwards, two at a time, so that the
+		last digit is just before end. Returns the first digit.
+	*/
+	char* WriteDigits(std::uint64_t val, char *end)
+	{
+		while (val >= 100)
+		{
+			end -= 2;
+			std::memcpy(end, digit_pairs + (val % 100) * 2, 2);
+			val /= 100;
+		}
+		if (val >= 10)
+		{
+			end -= 2;
+			std::memcpy(end, digit_pairs + val * 2, 2);
+		}
+		else
+			*--end = static_cast<char>('0' + val);
+		return end;
+	}
+	
+	char* Copy(char *out, const char *str, std::size_t len)
+	{
+		std::memcpy(out, str, len);
+		return out + len;
+	}
+	
+	char* Fill(char *out, char ch, std::size_t len)
+	{
+		std::memset(out, ch, len);
+		return out + len;
+	}
+
+	std::uint64_t MultiplyHigh(std::uint64_t a, std::uint64_t b)
+	{
+#ifdef __SIZEOF_INT128__
+		return static_cast<std::uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#else
+		std::uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+		std::uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+		std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+		std::uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+		return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+	}
+
+	// parameters of double for the Schubfach algorithm
+	const int			mantissa_bits	= 52;
+	const int			q_min			= -1074;	//!< exponent of the smallest subnormal
+	const int			k_min			= -324;		//!< first power in power_of_ten_126
+	const std::uint64_t	c_min			= 1ULL << mantissa_bits;
+	const std::uint64_t	c_tiny			= 3;		//!< subnormals below it need one more digit
+	const std::uint64_t	mask_63			= (1ULL << 63) - 1;
+
+	// floor(e * log10(2)), floor(e * log10(3/4 * 2)) and floor(e * log2(10))
+	int FloorLog10Pow2(int e)
+	{
+		return static_cast<int>(e * 661971961083LL >> 41);
+	}
+	int FloorLog10ThreeQuartersPow2(int e)
+	{
+		return static_cast<int>((e * 661971961083LL - 274743187321LL) >> 41);
+	}
+	int FloorLog2Pow10(int e)
+	{
+		return static_cast<int>(e * 913124641741LL >> 38);
+	}
+
+	/*	Multiplies cp by the 126-bit g = g1 * 2^63 + g0 and keeps the upper
+		bits. The lowest bit is set if any of the discarded bits is set ("round
+		to odd"), which is enough to compare the result with the boundaries.
+	*/
+	std::uint64_t RoundOdd(std::uint64_t g1, std::uint64_t g0, std::uint64_t cp)
+	{
+		std::uint64_t x1 = MultiplyHigh(g0, cp);
+		std::uint64_t y0 = g1 * cp;
+		std::uint64_t y1 = MultiplyHigh(g1, cp);
+		std::uint64_t z  = (y0 >> 1) + x1;
+		std::uint64_t vb = y1 + (z >> 63);
+		return vb | (((z & mask_63) + mask_63) >> 63);
+	}
+
+	/*	Finds the shortest decimal f * 10^e that converts back to c * 2^q, and
+		the closest one to it if there are several. This is the Schubfach
+		algorithm by Raffaello Giulietti: the digits are computed by a single
+		multiplication with an approximation of 10^-k, and the rounding
+		interval is checked with the same approximation.
+		See https://drive.google.com/file/d/1IEeATSVnEE6TkrHlCYNY2GjaraBjOT4f
+	*/
+	void ToDecimal(int q, std::uint64_t c, int dk, std::uint64_t& f, int& e)
+	{
+		std::uint64_t out = c & 1;
+		std::uint64_t cb  = c << 2;
+		std::uint64_t cbr = cb + 2;
+		std::uint64_t cbl;
+		int k;
+		
+		// the interval is not symmetric at powers of two
+		if (c != c_min || q == q_min)
+		{
+			cbl = cb - 2;
+			k   = FloorLog10Pow2(q);
+		}
+		else
+		{
+			cbl = cb - 1;
+			k   = FloorLog10ThreeQuartersPow2(q);
+		}
+		int h = q + FloorLog2Pow10(-k) + 2;
+		
+		const std::uint64_t *g = detail::power_of_ten_126 + 2 * (k - k_min);
+		std::uint64_t vb  = RoundOdd(g[0], g[1], cb << h);
+		std::uint64_t vbl = RoundOdd(g[0], g[1], cbl << h);
+		std::uint64_t vbr = RoundOdd(g[0], g[1], cbr << h);
+		
+		// try one digit less first
+		std::uint64_t s = vb >> 2;
+		if (s >= 10)
+		{
+			std::uint64_t sp10 = s / 10 * 10;
+			std::uint64_t tp10 = sp10 + 10;
+			bool upin = vbl + out <= sp10 << 2;
+			bool wpin = (tp10 << 2) + out <= vbr;
+			if (upin != wpin)
+			{
+				f = upin ? sp10 : tp10;
+				e = k + dk;
+				return;
+			}
+		}
+		
+		std::uint64_t t = s + 1;
+		bool uin = vbl + out <= s << 2;
+		bool win = (t << 2) + out <= vbr;
+		e = k + dk;
+		if (uin != win)
+		{
+			f = uin ? s : t;
+			return;
+		}
+		
+		// both are in the interval: take the closer one, or the even one on a tie
+		std::int64_t cmp = static_cast<std::int64_t>(vb - ((s + t) << 1));
+		f = (cmp < 0 || (cmp == 0 && (s & 1) == 0)) ? s : t;
+	}
+	
+	/*	Writes f * 10^e like JavaScript does: in plain notation if the decimal
+		point is near the digits, otherwise in exponent notation. Values that
+		look like integers get a ".0" so that they are parsed as reals again.
+	*/
+	char* WriteDecimal(std::uint64_t f, int e, char *out)
+	{
+		assert(f != 0);
+		while (f % 10 == 0)
+		{
+			f /= 10;
+			++e;
+		}
+		
+		char buf[max_int_size];
+		char *end	= buf + sizeof(buf);
+		char *begin	= WriteDigits(f, end);
+		int len		= static_cast<int>(end - begin);
+		int point	= len + e;	//!< number of digits before the decimal point
+		
+		if (e >= 0 && point <= 21)
+		{
+			out = Copy(out, begin, len);
+			out = Fill(out, '0', e);
+			out = Copy(out, ".0", 2);
+		}
+		else if (point > 0 && point <= 21)
+		{
+			out = Copy(out, begin, point);
+			*out++ = '.';
+			out = Copy(out, begin + point, len - point);
+		}
+		else if (point > -6 && point <= 0)
+		{
+			out = Copy(out, "0.", 2);
+			out = Fill(out, '0', -point);
+			out = Copy(out, begin, len);
+		}
+		else
+		{
+			*out++ = *begin;
+			if (len > 1)
+			{
+				*out++ = '.';
+				out = Copy(out, begin + 1, len - 1);
+			}
+			*out++ = 'e';
+			if (point - 1 < 0)
+				*out++ = '-';
+			
+			char *exp = WriteDigits(static_cast<std::uint64_t>(point > 0 ? point - 1 : 1 - point), end);
+			out = Copy(out, exp, end - exp);
+		}
+		return out;
+	}
+
+	bool NeedsEscape(char ch)
+	{
+		return static_cast<unsigned char>(ch) < 0x20 || ch == '"' || ch == '\\';
+	}
+
+	// SWAR: the result is not zero if any byte of v is zero
+	std::uint64_t HasZero(std::uint64_t v)
+	{
+		return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+	}
+
+	// SWAR: checks 8 characters at a time for quotes, backslashes and control characters
+	bool WordNeedsEscape(std::uint64_t v)
+	{
+		std::uint64_t control = (v - 0x2020202020202020ULL) & ~v & 0x8080808080808080ULL;
+		return (control | HasZero(v ^ 0x2222222222222222ULL) | HasZero(v ^ 0x5C5C5C5C5C5C5C5CULL)) != 0;
+	}
+
+	void AppendEscape(std::string& out, char ch)
+	{
+		switch (ch)
+		{
+		case '"':	out.append("\\\"", 2);	break;
+		case '\\':	out.append("\\\\", 2);	break;
+		case '\b':	out.append("\\b", 2);	break;
+		case '\f':	out.append("\\f", 2);	break;
+		case '\n':	out.append("\\n", 2);	break;
+		case '\r':	out.append("\\r", 2);	break;
+		case '\t':	out.append("\\t", 2);	break;
+		default:
+		{
+			// other control characters
+			const char esc[] = {'\\', 'u', '0', '0', hex_digits[(ch >> 4) & 0xF], hex_digits[ch & 0xF]};
+			out.append(esc, sizeof(esc));
+			break;
+		}
+		}
+	}
+}
+
+/**	Writes an integer in decimal.
+
+	\param	out	The buffer of at least max_int_size characters.
+	\return	The number of characters written. No null is appended.
+*/
+std::size_t FormatInt(long long val, char *out)
+{
+	if (val >= 0)
+		return FormatUint(static_cast<unsigned long long>(val), out);
+	
+	*out = '-';
+	return FormatUint(0 - static_cast<unsigned long long>(val), out + 1) + 1;
+}
+
+std::size_t FormatUint(unsigned long long val, char *out)
+{
+	char buf[max_int_size];
+	char *end	= buf + sizeof(buf);
+	char *begin	= WriteDigits(val, end);
+	return static_cast<std::size_t>(Copy(out, begin, end - begin) - out);
+}
+
+/**	Writes a real with the shortest digits that convert back to the same
+	double.
+
+	Infinity and NaN cannot be represented in JSON, so they are written as
+	null. Integral values are written with a ".0".
+	
+	\param	out	The buffer of at least max_real_size characters.
+	\return	The number of characters written. No null is appended.
+*/
+std::size_t FormatReal(double val, char *out)
+{
+	std::uint64_t bits;
+	std::memcpy(&bits, &val, sizeof(bits));
+	
+	std::uint64_t t	= bits & (c_min - 1);
+	int bq			= static_cast<int>(bits >> mantissa_bits) & 0x7FF;
+	
+	if (bq == 0x7FF)
+		return static_cast<std::size_t>(Copy(out, "null", 4) - out);
+	
+	char *p = out;
+	if (bits >> 63)
+		*p++ = '-';
+	
+	std::uint64_t f;
+	int e = 0;
+	if (bq != 0)
+	{
+		int mq = -q_min + 1 - bq;
+		std::uint64_t c = c_min | t;
+		
+		// small integers
+		if (mq > 0 && mq < mantissa_bits + 1 && ((c >> mq) << mq) == c)
+			f = c >> mq;
+		else
+			ToDecimal(-mq, c, 0, f, e);
+	}
+	else if (t == 0)
+		return static_cast<std::size_t>(Copy(p, "0.0", 3) - out);
+	else if (t < c_tiny)
+		ToDecimal(q_min, 10 * t, -1, f, e);
+	else
+		ToDecimal(q_min, t, 0, f, e);
+	
+	return static_cast<std::size_t>(WriteDecimal(f, e, p) - out);
+}
+
+/**	Appends a string escaped for JSON without the quotes.
+
+	Quotes, backslashes and control characters are escaped. Other characters,
+	including UTF-8 sequences, are copied as they are. The string is scanned 8
+	bytes at a time, and the runs without escapes are copied in one go.
+*/
+void AppendEscaped(std::string& out, const char *str, std::size_t len)
+{
+	const char *p	= str;
+	const char *end	= str + len;
+	const char *run	= str;
+	
+	while (p != end)
+	{
+		const char *stop = end;
+		if (end - p >= 8)
+		{
+			std::uint64_t w;
+			std::memcpy(&w, p, sizeof(w));
+			if (!WordNeedsEscape(w))
+			{
+				p += 8;
+				continue;
+			}
+			stop = p + 8;
+		}
+		
+		for ( ; p != stop ; ++p)
+		{
+			if (NeedsEscape(*p))
+			{
+				out.append(run, p);
+				AppendEscape(out, *p);
+				run = p + 1;
+			}
+		}
+	}
+	out.append(run, end);
+}
+
+struct Writer::Visitor
+{
+	Writer& w;
+	
+	void operator()(long long val)		{w.Int(val);}
+	void operator()(double val)			{w.Real(val);}
+	void operator()(bool val)			{w.Bool(val);}
+	void operator()(const StringView& s)	{w.String(s);}
+	
+	void operator()(const JVar::Hash& hash)
+	{
+		bool first = true;
+		w.Raw('{');
+		for (const auto& e : hash)
+		{
+			if (!first)
+				w.Raw(',');
+			w.String(e.first.View());
+			w.Raw(':');
+			w.Value(e.second);
+			first = false;
+		}
+		w.Raw('}');
+	}
+	
+	void operator()(const JVar::Array& array)
+	{
+		bool first = true;
+		w.Raw('[');
+		for (const auto& e : array)
+		{
+			if (!first)
+				w.Raw(',');
+			w.Value(e);
+			first = false;
+		}
+		w.Raw(']');
+	}
+};
+
+const std::size_t Writer::default_chunk_size;
+
+Writer::Writer(std::string& out) : m_out(out), m_chunk(0)
+{
+}
+
+Writer::Writer(const Sink& sink, std::size_t chunk_size) :
+	m_out(m_own),
+	m_sink(sink),
+	m_chunk(chunk_size)
+{
+	assert(m_sink);
+	assert(m_chunk > 0);
+	m_own.reserve(m_chunk * 2);
+}
+
+/**	Writes a JVar and all its children.
+*/
+void Writer::Value(const JVar& var)
+{
+	if (var.IsNull())
+		Null();
+	else
+		var.Apply(Visitor{*this});
+}
+
+void Writer::Null()
+{
+	m_out.append("null", 4);
+	Written();
+}
+
+void Writer::Bool(bool val)
+{
+	if (val)
+		m_out.append("true", 4);
+	else
+		m_out.append("false", 5);
+	Written();
+}
+
+void Writer::Int(long long val)
+{
+	char buf[max_int_size];
+	m_out.append(buf, FormatInt(val, buf));
+	Written();
+}
+
+void Writer::Uint(unsigned long long val)
+{
+	char buf[max_int_size];
+	m_out.append(buf, FormatUint(val, buf));
+	Written();
+}
+
+void Writer::Real(double val)
+{
+	char buf[max_real_size];
+	m_out.append(buf, FormatReal(val, buf));
+	Written();
+}
+
+/**	Writes a quoted and escaped string.
+*/
+void Writer::String(const char *str, std::size_t len)
+{
+	m_out.push_back('"');
+	AppendEscaped(m_out, str, len);
+	m_out.push_back('"');
+	Written();
+}
+
+void Writer::String(const StringView& str)
+{
+	String(str.data(), str.size());
+}
+
+/**	Writes text without escaping, e.g. a separator or a pre-escaped key.
+*/
+void Writer::Raw(const char *str, std::size_t len)
+{
+	m_out.append(str, len);
+	Written();
+}
+
+void Writer::Raw(char ch)
+{
+	m_out.push_back(ch);
+	Written();
+}
+
+/// The string that the JSON text is appended to. With a sink, it is the text not passed to the sink yet.
+std::string& Writer::Buffer()
+{
+	return m_out;
+}
+
+/**	Passes all text in the buffer to the sink, including the last partial
+	chunk. It does nothing without a sink.
+*/
+void Writer::Flush()
+{
+	if (m_sink && !m_out.empty())
+	{
+		Drain();
+		if (!m_out.empty())
+			m_sink(m_out.data(), m_out.size());
+		m_out.clear();
+	}
+}
+
+// passes the full chunks to the sink and keeps the rest
+void Writer::Drain()
+{
+	std::size_t pos = 0;
+	for ( ; m_out.size() - pos >= m_chunk ; pos += m_chunk)
+		m_sink(m_out.data() + pos, m_chunk);
+	m_out.erase(0, pos);
+}
+
+StreamWriter::StreamWriter(std::string& out) :
+	m_out(out),
+	m_after_key(false)
+{
+}
+
+StreamWriter::StreamWriter(const Writer::Sink& sink, std::size_t chunk_size) :
+	m_out(sink, chunk_size),
+	m_after_key(false)
+{
+}
+
+void StreamWriter::StartObject()
+{
+	Separator();
+	m_out.Raw('{');
+	m_levels.push_back(Level{true, true});
+}
+
+void StreamWriter::EndObject()
+{
+	assert(!m_levels.empty() && m_levels.back().object && !m_after_key);
+	m_levels.pop_back();
+	m_out.Raw('}');
+}
+
+void StreamWriter::StartArray()
+{
+	Separator();
+	m_out.Raw('[');
+	m_levels.push_back(Level{false, true});
+}
+
+void StreamWriter::EndArray()
+{
+	assert(!m_levels.empty() && !m_levels.back().object);
+	m_levels.pop_back();
+	m_out.Raw(']');
+}
+
+/**	Writes the key of the next member of an object.
+*/
+void StreamWriter::Key(const char *str, std::size_t len)
+{
+	assert(!m_levels.empty() && m_levels.back().object && !m_after_key);
+	
+	Level& level = m_levels.back();
+	if (!level.empty)
+		m_out.Raw(',');
+	level.empty = false;
+	
+	m_out.String(str, len);
+	m_out.Raw(':');
+	m_after_key = true;
+}
+
+void StreamWriter::Key(const StringView& str)
+{
+	Key(str.data(), str.size());
+}
+
+void StreamWriter::Value(const JVar& var)
+{
+	Separator();
+	m_out.Value(var);
+}
+
+void StreamWriter::Null()
+{
+	Separator();
+	m_out.Null();
+}
+
+void StreamWriter::Bool(bool val)
+{
+	Separator();
+	m_out.Bool(val);
+}
+
+void StreamWriter::Int(long long val)
+{
+	Separator();
+	m_out.Int(val);
+}
+
+void StreamWriter::Uint(unsigned long long val)
+{
+	Separator();
+	m_out.Uint(val);
+}
+
+void StreamWriter::Real(double val)
+{
+	Separator();
+	m_out.Real(val);
+}
+
+void StreamWriter::String(const char *str, std::size_t len)
+{
+	Separator();
+	m_out.String(str, len);
+}
+
+void StreamWriter::String(const StringView& str)
+{
+	String(str.data(), str.size());
+}
+
+/**	Prepares for a value written directly by the Writer, e.g. by Serialize().
+	Exactly one value must be written to the returned Writer.
+*/
+Writer& StreamWriter::Element()
+{
+	Separator();
+	return m_out;
+}
+
+void StreamWriter::Flush()
+{
+	m_out.Flush();
+}
+
+// the comma before an element of an array
+void StreamWriter::Separator()
+{
+	if (m_after_key)
+	{
+		m_after_key = false;
+		return;
+	}
+	
+	assert(m_levels.empty() || !m_levels.back().object);
+	if (!m_levels.empty())
+	{
+		if (!m_levels.back().empty)
+			m_out.Raw(',');
+		m_levels.back().empty = false;
+	}
+}
+
+/**	Writes null for processors that do not support writing.
+*/
+void JsonProcessor::Write(const Cursor&, Writer& out) const
+{
+	out.Null();
+}
+
+} // end of namespace
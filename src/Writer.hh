@@ -0,0 +1,185 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#ifndef WRITER_HH_INCLUDED
+#define WRITER_HH_INCLUDED
+
+#include "StringView.hh"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace json {
+
+class JVar;
+
+//! Buffer size required by FormatInt().
+const std::size_t max_int_size	= 20;
+
+//! Buffer size required by FormatReal().
+const std::size_t max_real_size	= 25;
+
+std::size_t FormatInt(long long val, char *out);
+std::size_t FormatUint(unsigned long long val, char *out);
+std::size_t FormatReal(double val, char *out);
+void AppendEscaped(std::string& out, const char *str, std::size_t len);
+
+/**	Serializes JSON values into a string.
+
+	Writer appends compact JSON text to the string given to its constructor.
+	The string is a growable buffer that can be reused between documents:
+	clear() it and keep its capacity.
+	
+	Strings are escaped as required by JSON, and reals are written with the
+	shortest digits that convert back to the same double. Value() writes a
+	whole JVar. The other functions write a single token, so the caller is
+	responsible for the commas and colons between them.
+	
+	\code{.cpp}
+	std::string json;
+	Writer w(json);
+	w.Value(var);
+	\endcode
+	
+	A Writer constructed with a sink writes to its own buffer instead. Whenever
+	the buffer holds a full chunk after a token is written, the full chunks are
+	passed to the sink, so the buffer never holds more than a chunk and a token.
+	The sink may block to slow down the writer, e.g. when writing to a socket.
+	Call Flush() at the end to pass the last partial chunk.
+*/
+class Writer
+{
+public:
+	//! Receives the JSON text in chunks.
+	using Sink = std::function<void(const char *data, std::size_t len)>;
+	
+	static const std::size_t default_chunk_size = 64 * 1024;
+	
+public:
+	explicit Writer(std::string& out);
+	explicit Writer(const Sink& sink, std::size_t chunk_size = default_chunk_size);
+	
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+	
+	void Value(const JVar& var);
+	
+	void Null();
+	void Bool(bool val);
+	void Int(long long val);
+	void Uint(unsigned long long val);
+	void Real(double val);
+	void String(const char *str, std::size_t len);
+	void String(const StringView& str);
+	
+	void Raw(const char *str, std::size_t len);
+	void Raw(char ch);
+	
+	std::string& Buffer();
+	void Flush();
+
+private:
+	struct Visitor;
+	
+	void Written()
+	{
+		if (m_sink && m_out.size() >= m_chunk)
+			Drain();
+	}
+	void Drain();
+
+private:
+	std::string		m_own;		//!< the buffer used with a sink
+	std::string&	m_out;
+	
+	Sink			m_sink;
+	std::size_t		m_chunk;
+};
+
+/**	Writes JSON token by token, adding the commas and colons.
+
+	StreamWriter is an incremental interface on top of Writer. The document is
+	written by calling StartObject(), Key(), the value functions, EndObject()
+	and so on in the order of the text. With a sink, the text is passed on in
+	chunks as it is written, so a document of any size is generated in constant
+	memory.
+	
+	\code{.cpp}
+	StreamWriter w([fd](const char *data, std::size_t len) { ::write(fd, data, len); });
+	w.StartArray();
+	for (const auto& row : rows)
+	{
+		w.StartObject();
+		w.Key("id", 2);
+		w.Int(row.id);
+		w.EndObject();
+	}
+	w.EndArray();
+	w.Flush();
+	\endcode
+	
+	The calls are only checked by assertions, so they must form a valid
+	document.
+*/
+class StreamWriter
+{
+public:
+	explicit StreamWriter(std::string& out);
+	explicit StreamWriter(const Writer::Sink& sink, std::size_t chunk_size = Writer::default_chunk_size);
+	
+	void StartObject();
+	void EndObject();
+	void StartArray();
+	void EndArray();
+	void Key(const char *str, std::size_t len);
+	void Key(const StringView& str);
+	
+	void Value(const JVar& var);
+	void Null();
+	void Bool(bool val);
+	void Int(long long val);
+	void Uint(unsigned long long val);
+	void Real(double val);
+	void String(const char *str, std::size_t len);
+	void String(const StringView& str);
+	
+	Writer& Element();
+	void Flush();
+
+private:
+	void Separator();
+
+private:
+	struct Level
+	{
+		bool	object;
+		bool	empty;
+	};
+
+	Writer				m_out;
+	std::vector<Level>	m_levels;
+	bool				m_after_key;
+};
+
+} // end of namespace
+
+#endif
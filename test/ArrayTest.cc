@@ -23,6 +23,8 @@
 #include "JsonParser.hh"
 #include "JsonBuilder.hh"
 #include "VectorBuilder.hh"
+#include "ArraySinkBuilder.hh"
+#include "JVarBuilder.hh"
 
 #include <vector>
 #include <deque>
@@ -120,3 +122,200 @@ TEST_F(ItemArrayTest, VectorArrayTest)
 	ASSERT_EQ("Title of item[0]", 	list.items[0].title);
 	ASSERT_EQ("Folder's Title",		list.items[1].title);
 }
+
+TEST_F(ItemArrayTest, ReuseElements)
+{
+	VectorBuilder<Item> h(item_level, 0, true);
+	JsonParser sub(&h);
+	
+	std::vector<Item> items(1);
+	items[0].title.reserve(100);
+	const char *title = items[0].title.data();
+	
+	const char json1[] = "[{\"title\": \"first\"}, {\"title\": \"second\"}, {\"title\": \"third\"}]";
+	sub.Parse(json1, sizeof(json1)-1, &items);
+	sub.Done();
+	ASSERT_EQ(3, items.size());
+	ASSERT_EQ("first", items[0].title);
+	ASSERT_EQ(title, items[0].title.data());
+	ASSERT_EQ("third", items[2].title);
+	
+	const char json2[] = "[{\"title\": \"again\", \"page\": 1}, {\"page\": 2}]";
+	sub.Parse(json2, sizeof(json2)-1, &items);
+	sub.Done();
+	ASSERT_EQ(2, items.size());
+	ASSERT_EQ("again", items[0].title);
+	ASSERT_EQ(title, items[0].title.data());
+	ASSERT_EQ(2, items[1].page);
+	
+	// members missing in the JSON are reset
+	ASSERT_EQ("", items[1].title);
+}
+
+TEST_F(ItemArrayTest, WriteArrays)
+{
+	struct Items
+	{
+		Item item0;
+		Item item1;
+	};
+	
+	struct FileList
+	{
+		std::string			kind;
+		std::vector<Item>	items;
+		Items				pair;
+	};
+	
+	JsonBuilder<FileList> list_level =
+	{
+		{"kind",  &FileList::kind},
+		{"items", &FileList::items, VectorBuilder<Item>(item_level)},
+		{"pair",  &FileList::pair, JsonBuilder<Items>{
+			{1, &Items::item1, item_level},
+			{2, &Items::item0, item_level},
+		}}
+	};
+	
+	FileList list;
+	JsonParser sub(&list_level);
+	sub.Parse(m_json.data(), m_json.size(), &list);
+	sub.Done();
+	list.pair.item1.title = "p";
+	
+	std::string json;
+	Writer out(json);
+	Serialize(list_level, list, out);
+	
+	// objects with index keys are written as arrays
+	const char pair[] = ",\"pair\":[null,{\"kind\":\"\",\"title\":\"p\",\"page\":0},";
+	ASSERT_NE(std::string::npos, json.find(pair)) << json;
+	
+	FileList copy;
+	sub.Parse(json.data(), json.size(), &copy);
+	sub.Done();
+	ASSERT_EQ(list.kind, copy.kind);
+	ASSERT_EQ(2, copy.items.size());
+	ASSERT_EQ(list.items[1].title, copy.items[1].title);
+	ASSERT_EQ(list.items[0].page, copy.items[0].page);
+	ASSERT_EQ("p", copy.pair.item1.title);
+}
+
+TEST(ArrayTest, CapacityHint)
+{
+	std::string json = "[0";
+	for (int i = 1 ; i < 100 ; ++i)
+		json += "," + std::to_string(i);
+	json += "]";
+	
+	VectorBuilder<int> h{SimpleTypeBuilder<int>(), 1000};
+	VectorBuilder<int> learn{SimpleTypeBuilder<int>()};
+	
+	std::vector<int> v1, v2, v3;
+	JsonParser{&h}.Parse(json.data(), json.size(), &v1);
+	ASSERT_EQ(100, v1.size());
+	ASSERT_LE(1000, v1.capacity());
+	
+	// the second parse reserves the size of the first
+	JsonParser{&learn}.Parse(json.data(), json.size(), &v2);
+	JsonParser{&learn}.Parse(json.data(), json.size(), &v3);
+	ASSERT_EQ(100, v3.size());
+	ASSERT_LE(100, v3.capacity());
+	ASSERT_EQ(v2, v3);
+}
+
+TEST_F(ItemArrayTest, ArraySink)
+{
+	struct FileList
+	{
+		std::string kind;
+		ArraySink<Item> items;
+	};
+
+	JsonBuilder<FileList> list_level =
+	{
+		{"kind", &FileList::kind},
+		{"items", &FileList::items, ArraySinkBuilder<Item>(item_level)}
+	};
+	JsonParser sub(&list_level);
+	
+	std::vector<std::string> titles;
+	const Item *storage = nullptr;
+	
+	FileList list;
+	list.items.callback = [&titles, &storage](Item& item)
+	{
+		titles.push_back(item.title);
+		storage = &item;
+	};
+	
+	// feed one byte at a time to check the elements come before the end
+	std::size_t second = m_json.find("\"folder\"");
+	ASSERT_NE(std::string::npos, second);
+	
+	sub.SetTarget(&list);
+	for (std::size_t i = 0 ; i < m_json.size() ; ++i)
+	{
+		if (i == second)
+		{
+			ASSERT_EQ(1, titles.size());
+		}
+		sub.Parse(&m_json[i], 1);
+	}
+	
+	ASSERT_EQ("hello world!", list.kind);
+	ASSERT_EQ((std::vector<std::string>{"Title of item[0]", "Folder's Title"}), titles);
+	ASSERT_EQ(&list.items.element, storage);
+}
+
+TEST(ArrayTest, ArraySinkOfNumbers)
+{
+	ArraySinkBuilder<int> h{SimpleTypeBuilder<int>()};
+	JsonParser sub(&h);
+	
+	int sum = 0;
+	ArraySink<int> sink{[&sum](int& i) { sum += i; }};
+	
+	const char json[] = "[1, 2, 3, 4]";
+	sub.Parse(json, sizeof(json)-1, &sink);
+	ASSERT_EQ(10, sum);
+}
+
+TEST(ArrayTest, ArraySinkOfJVars)
+{
+	ArraySinkBuilder<JVar> h{JVarBuilder()};
+	JsonParser sub(&h);
+	
+	std::vector<std::string> elems;
+	ArraySink<JVar> sink{[&elems](JVar& v)
+	{
+		std::string json;
+		Writer(json).Value(v);
+		elems.push_back(json);
+	}};
+	
+	// the element builder starts each array and object
+	const char json[] = "[[1,2],{\"a\":1},[3]]";
+	sub.Parse(json, sizeof(json)-1, &sink);
+	ASSERT_EQ((std::vector<std::string>{"[1,2]", "{\"a\":1}", "[3]"}), elems);
+}
+
+TEST_F(ItemArrayTest, ArraySinkResetsElement)
+{
+	ArraySinkBuilder<Item> h{item_level};
+	JsonParser sub(&h);
+	
+	std::vector<Item> items;
+	ArraySink<Item> sink{[&items](Item& item) { items.push_back(item); }};
+	
+	// the second record has none of the members of the first one
+	const char json[] = "[{\"title\":\"a\",\"page\":5},{\"kind\":\"k\"}]";
+	sub.Parse(json, sizeof(json)-1, &sink);
+	
+	ASSERT_EQ(2, items.size());
+	ASSERT_EQ("a", items[0].title);
+	ASSERT_EQ(5, items[0].page);
+	ASSERT_EQ("k", items[1].kind);
+	ASSERT_EQ("", items[1].title);
+	ASSERT_EQ(0, items[1].page);
+}
@@ -23,6 +23,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -403,3 +404,14 @@ TEST_F(AutomatonTest, TestGDriveFile)
 	
 	ASSERT_TRUE(m_sub->Result());
 }
+
+TEST_F(AutomatonTest, TestParseFile)
+{
+	m_sub->ParseFile(TEST_DATA "array.json");
+	ASSERT_TRUE(m_sub->Result());
+	
+	ASSERT_FALSE(m_actual.empty());
+	ASSERT_EQ(Entry(DataType::object, Event::start, ""), m_actual.front());
+	ASSERT_EQ(Entry(DataType::object, Event::end, ""), m_actual.back());
+	ASSERT_EQ(3, std::count(m_actual.begin(), m_actual.end(), Entry(DataType::object, Event::start, "")));
+}
@@ -27,6 +27,7 @@
 
 using namespace json;
 
+#if AUTOJSON_CHECKED_CURSOR
 TEST(CursorTest, Get_pointer_with_the_wrong_type_will_throw)
 {
 	SimpleTypeBuilder<int> iv;
@@ -36,6 +37,7 @@ TEST(CursorTest, Get_pointer_with_the_wrong_type_will_throw)
 	
 	ASSERT_THROW(sub.Target<double>(), TypeMismatch);
 }
+#endif
 
 TEST(CursorTest, Get_pointer_with_the_right_type_will_return_it)
 {
@@ -0,0 +1,190 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include "Decompressor.hh"
+#include "ReadAhead.hh"
+#include "JsonParser.hh"
+#include "JVarBuilder.hh"
+#include "MappedFile.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+using namespace json;
+
+namespace
+{
+	// decompresses a file in small pieces to test the chunk boundaries
+	std::string Decompress(const char *path, Decompressor::Format format)
+	{
+		int fd = ::open(path, O_RDONLY);
+		EXPECT_GE(fd, 0);
+
+		std::string result;
+		{
+			Decompressor input(fd, 64);
+
+			char buf[100];
+			for (std::size_t len ; (len = input.Read(buf, sizeof(buf))) > 0 ; )
+				result.append(buf, len);
+			EXPECT_EQ(format, input.GetFormat());
+		}
+		::close(fd);
+		return result;
+	}
+}
+
+TEST(DecompressorTest, Plain)
+{
+	MappedFile expect(TEST_DATA "paddrive.json");
+	ASSERT_EQ(
+		std::string(expect.Data(), expect.Size()),
+		Decompress(TEST_DATA "paddrive.json", Decompressor::Format::plain));
+}
+
+TEST(DecompressorTest, GzipMembers)
+{
+	if (!Decompressor::IsSupported(Decompressor::Format::gzip))
+		GTEST_SKIP() << "gzip is not supported by this build";
+
+	// the file has two gzip members
+	MappedFile expect(TEST_DATA "paddrive.json");
+	ASSERT_EQ(
+		std::string(expect.Data(), expect.Size()),
+		Decompress(TEST_DATA "paddrive.json.gz", Decompressor::Format::gzip));
+}
+
+TEST(DecompressorTest, Zstd)
+{
+	if (!Decompressor::IsSupported(Decompressor::Format::zstd))
+		GTEST_SKIP() << "zstd is not supported by this build";
+
+	MappedFile expect(TEST_DATA "paddrive.json");
+	ASSERT_EQ(
+		std::string(expect.Data(), expect.Size()),
+		Decompress(TEST_DATA "paddrive.json.zst", Decompressor::Format::zstd));
+}
+
+TEST(DecompressorTest, ParseOnAnotherThread)
+{
+	const char *path = Decompressor::IsSupported(Decompressor::Format::zstd) ?
+		TEST_DATA "paddrive.json.zst" : TEST_DATA "paddrive.json";
+
+	int fd = ::open(path, O_RDONLY);
+	ASSERT_GE(fd, 0);
+
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h, 20);
+	sub.SetTarget(&var);
+	{
+		Decompressor input(fd, 256);
+		ReadAhead chunks([&input](char *buf, std::size_t size){ return input.Read(buf, size); }, 512);
+		chunks.Feed(sub);
+	}
+	::close(fd);
+
+	ASSERT_EQ("drive#fileList", var["kind"].Str());
+	ASSERT_LT(0, var["items"].Size());
+}
+
+TEST(DecompressorTest, TokenLongerThanChunk)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+
+	const std::string text(3000, 'x');
+	const std::string json = "[\"" + text + "\"]";
+	std::thread writer([&fds, &json]
+	{
+		ASSERT_EQ(static_cast<long>(json.size()), ::write(fds[1], json.data(), json.size()));
+		::close(fds[1]);
+	});
+
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h);
+	sub.SetTarget(&var);
+	{
+		Decompressor input(fds[0], 256);
+		ReadAhead chunks([&input](char *buf, std::size_t size){ return input.Read(buf, size); }, 512);
+		chunks.Feed(sub);
+	}
+	writer.join();
+	::close(fds[0]);
+
+	ASSERT_TRUE(sub.Done());
+	ASSERT_EQ(text, var[0].Str());
+}
+
+TEST(DecompressorTest, Truncated)
+{
+	if (!Decompressor::IsSupported(Decompressor::Format::gzip))
+		GTEST_SKIP() << "gzip is not supported by this build";
+
+	MappedFile gz(TEST_DATA "paddrive.json.gz");
+
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+	ASSERT_EQ(100, ::write(fds[1], gz.Data(), 100));
+	::close(fds[1]);
+
+	Decompressor input(fds[0]);
+	std::string result;
+	try
+	{
+		char buf[100];
+		for (std::size_t len ; (len = input.Read(buf, sizeof(buf))) > 0 ; )
+			result.append(buf, len);
+		FAIL();
+	}
+	catch (DecompressError& e)
+	{
+		ASSERT_NE(nullptr, e.Get<MessageInfo>());
+	}
+	::close(fds[0]);
+}
+
+TEST(DecompressorTest, Unsupported)
+{
+	const char *path = nullptr;
+	if (!Decompressor::IsSupported(Decompressor::Format::zstd))
+		path = TEST_DATA "paddrive.json.zst";
+	else if (!Decompressor::IsSupported(Decompressor::Format::gzip))
+		path = TEST_DATA "paddrive.json.gz";
+	else
+		GTEST_SKIP() << "all formats are supported by this build";
+	
+	int fd = ::open(path, O_RDONLY);
+	ASSERT_GE(fd, 0);
+	
+	// reading again throws again
+	Decompressor input(fd);
+	char buf[100];
+	ASSERT_THROW(input.Read(buf, sizeof(buf)), DecompressError);
+	ASSERT_THROW(input.Read(buf, sizeof(buf)), DecompressError);
+	ASSERT_EQ(Decompressor::Format::unknown, input.GetFormat());
+	::close(fd);
+}
@@ -0,0 +1,96 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include "Document.hh"
+#include "JsonParser.hh"
+
+#include <cstdint>
+#include <string>
+
+using namespace json;
+
+TEST(DocumentTest, ArenaAlignment)
+{
+	Arena arena(64);
+	
+	char *c = static_cast<char*>(arena.Allocate(1, 1));
+	double *d = static_cast<double*>(arena.Allocate(sizeof(double), alignof(double)));
+	ASSERT_NE(nullptr, c);
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(d) % alignof(double));
+	
+	// larger than a block
+	void *big = arena.Allocate(1000, 16);
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(big) % 16);
+	ASSERT_EQ(1 + sizeof(double) + 1000, arena.Size());
+	
+	arena.Release();
+	ASSERT_EQ(0, arena.Size());
+}
+
+TEST(DocumentTest, ParseIntoArena)
+{
+	const char json[] =
+		"{\"kind\": \"drive#fileList\", \"items\": [{\"title\": \"a very long title that is not inline\"}, 2, 3.5], "
+		"\"empty\": {}}";
+	
+	Document doc;
+	JsonParser sub(doc.Builder());
+	sub.Parse(json, sizeof(json)-1, &doc.Root());
+	
+	const JVar& root = doc.Root();
+	ASSERT_EQ(3, root.Size());
+	ASSERT_EQ("drive#fileList", root["kind"]);
+	ASSERT_EQ("a very long title that is not inline", root["items"][0]["title"]);
+	ASSERT_EQ(2, root["items"][1]);
+	ASSERT_EQ(3.5, root["items"][2].Real());
+	
+	ASSERT_EQ(&doc.GetArena(), root.GetArena());
+	ASSERT_EQ(&doc.GetArena(), root["items"].GetArena());
+	ASSERT_EQ(&doc.GetArena(), root["items"][0]["title"].GetArena());
+	ASSERT_EQ(&doc.GetArena(), root["empty"].GetArena());
+	ASSERT_LT(0, doc.GetArena().Size());
+	
+	// copies go to the heap
+	JVar copy = root["items"];
+	ASSERT_EQ(nullptr, copy.GetArena());
+	ASSERT_EQ(nullptr, copy[0]["title"].GetArena());
+	ASSERT_EQ("a very long title that is not inline", copy[0]["title"]);
+}
+
+TEST(DocumentTest, ImportAndClear)
+{
+	JVar val;
+	val.Add("name", "a string that is longer than the small string buffer");
+	val.Add("list", JVar().Add(1).Add("two"));
+	
+	Document doc;
+	doc.Root() = doc.Import(val);
+	ASSERT_EQ(&doc.GetArena(), doc.Root().GetArena());
+	ASSERT_EQ(&doc.GetArena(), doc.Root()["list"].GetArena());
+	ASSERT_EQ(&doc.GetArena(), doc.Root()["name"].GetArena());
+	ASSERT_EQ("two", doc.Root()["list"][1]);
+	ASSERT_EQ(val["name"].Str(), doc.Root()["name"].Str());
+	
+	doc.Clear();
+	ASSERT_TRUE(doc.Root().IsNull());
+	ASSERT_EQ(0, doc.GetArena().Size());
+}
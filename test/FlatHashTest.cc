@@ -0,0 +1,138 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2014  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "FlatHash.hh"
+#include "Arena.hh"
+#include "JVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace json;
+
+namespace
+{
+	StringView View(const std::string& s)
+	{
+		return StringView{s.data(), s.data() + s.size()};
+	}
+	
+	std::vector<std::string> Keys(const FlatHash<int>& hash)
+	{
+		std::vector<std::string> keys;
+		for (const auto& e : hash)
+			keys.emplace_back(e.first.data(), e.first.size());
+		return keys;
+	}
+}
+
+TEST(FlatHashTest, IterateInKeyOrder)
+{
+	FlatHash<int> subject;
+	subject[View("kind")] = 1;
+	subject[View("etag")] = 2;
+	subject[View("selfLink")] = 3;
+	ASSERT_FALSE(subject.emplace(View("etag"), 4).second);
+	
+	ASSERT_EQ(3, subject.size());
+	ASSERT_EQ((std::vector<std::string>{"etag", "kind", "selfLink"}), Keys(subject));
+	ASSERT_EQ(2, subject.at(View("etag")));
+	ASSERT_EQ(1, subject.count(View("kind")));
+	ASSERT_EQ(0, subject.count(View("id")));
+	ASSERT_THROW(subject.at(View("id")), std::out_of_range);
+	
+	ASSERT_EQ(1, subject.erase(View("kind")));
+	ASSERT_EQ((std::vector<std::string>{"etag", "selfLink"}), Keys(subject));
+}
+
+TEST(FlatHashTest, LookupAboveThreshold)
+{
+	const std::size_t n = FlatHash<int>::index_threshold * 10;
+	
+	// keys inserted in reverse order move the entries in the middle
+	FlatHash<int> subject;
+	for (std::size_t i = n ; i > 0 ; --i)
+		subject[View("key" + std::to_string(i))] = static_cast<int>(i);
+	
+	ASSERT_EQ(n, subject.size());
+	for (std::size_t i = 1 ; i <= n ; ++i)
+		ASSERT_EQ(static_cast<int>(i), subject.at(View("key" + std::to_string(i))));
+	ASSERT_EQ(subject.end(), subject.find(View("key0")));
+	
+	auto keys = Keys(subject);
+	ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+	
+	subject.erase(subject.find(View("key100")));
+	ASSERT_EQ(0, subject.count(View("key100")));
+	ASSERT_EQ(101, subject.at(View("key101")));
+}
+
+TEST(FlatHashTest, AppendKeepsLastValue)
+{
+	FlatHash<int> subject;
+	for (int round = 0 ; round < 2 ; ++round)
+		for (int i = 40 ; i > 0 ; --i)
+			subject.Append(View("key" + std::to_string(i)), i * 10 + round);
+	
+	// lookups before sealing find the last value too
+	ASSERT_EQ(80, subject.size());
+	ASSERT_EQ(71, subject.at(View("key7")));
+	
+	subject.Seal();
+	ASSERT_EQ(40, subject.size());
+	ASSERT_EQ(71, subject.at(View("key7")));
+	ASSERT_EQ(401, subject.at(View("key40")));
+	
+	auto keys = Keys(subject);
+	ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+}
+
+TEST(FlatHashTest, ParseLargeObject)
+{
+	std::ostringstream json;
+	json << "{";
+	for (int i = 0 ; i < 100 ; ++i)
+		json << "\"m" << (i * 37 % 100) << "\": " << i << ", ";
+	json << "\"m5\": \"last\"}";
+	const std::string str = json.str();
+	
+	Arena arena;
+	JVarBuilder h(&arena);
+	JsonParser sub(&h);
+	
+	JVar doc(Type::null, &arena);
+	sub.Parse(str.data(), str.size(), &doc);
+	sub.Done();
+	
+	ASSERT_EQ(100, doc.Size());
+	ASSERT_EQ(&arena, doc.GetArena());
+	ASSERT_EQ(1, doc["m37"].Long());
+	ASSERT_EQ("last", doc["m5"].Str());
+	
+	JVar copy = doc;
+	ASSERT_EQ(nullptr, copy.GetArena());
+	ASSERT_EQ(99, copy["m63"].Long());
+}
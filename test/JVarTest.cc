@@ -19,6 +19,8 @@
 */
 
 #include "JVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
 
 #include <functional>
 #include <cassert>
@@ -29,6 +31,7 @@
 #include <iostream>
 #include <memory>
 #include <map>
+#include <thread>
 
 using namespace json;
 
@@ -103,3 +106,158 @@ TEST(JVarTest, PrintToStdOut)
 	arr.Add(true);
 //	arr.Print(std::cout);
 }
+
+TEST(JVarTest, BuildFromParser)
+{
+	const char json[] =
+	"{"
+		"\"name\": \"Tom\\n\","
+		"\"age\": 42,"
+		"\"height\": 1.75,"
+		"\"big\": 12345678901234567890,"
+		"\"tags\": [\"a\", [], {}, null, true, false],"
+		"\"empty\": {},"
+		"\"nested\": {\"k\\u00e9\": [1, [2, 3]]}"
+	"}";
+	
+	JVarBuilder h;
+	JsonParser sub(&h);
+	
+	JVar doc;
+	sub.Parse(json, sizeof(json)-1, &doc);
+	
+	ASSERT_TRUE(doc.Is(Type::hash));
+	ASSERT_EQ(7, doc.Size());
+	ASSERT_EQ("Tom\n", doc["name"].Str());
+	ASSERT_TRUE(doc["age"].Is(Type::integer));
+	ASSERT_EQ(42, doc["age"].Long());
+	ASSERT_EQ(1.75, doc["height"].Real());
+	ASSERT_TRUE(doc["big"].Is(Type::real));
+	
+	const JVar& tags = doc["tags"];
+	ASSERT_EQ(6, tags.Size());
+	ASSERT_EQ("a", tags[0].Str());
+	ASSERT_TRUE(tags[1].Is(Type::array));
+	ASSERT_TRUE(tags[2].Is(Type::hash));
+	ASSERT_TRUE(tags[3].IsNull());
+	ASSERT_TRUE(tags[4].Bool());
+	ASSERT_FALSE(tags[5].Bool());
+	
+	ASSERT_TRUE(doc["empty"].Is(Type::hash));
+	ASSERT_EQ(0, doc["empty"].Size());
+	ASSERT_EQ(3, doc["nested"]["k\xc3\xa9"][1][1].Long());
+}
+
+TEST(JVarTest, BuildArrayInChunks)
+{
+	const char json[] = "[1, \"two\", [3.5, {\"four\": 4}], 5]";
+	
+	JVarBuilder h;
+	JsonParser sub(&h);
+	
+	JVar doc;
+	sub.SetTarget(&doc);
+	for (std::size_t i = 0 ; i < sizeof(json)-1 ; ++i)
+		sub.Parse(&json[i], 1);
+	
+	ASSERT_EQ(4, doc.Size());
+	ASSERT_EQ(1, doc[0].Long());
+	ASSERT_EQ("two", doc[1].Str());
+	ASSERT_EQ(3.5, doc[2][0].Real());
+	ASSERT_EQ(4, doc[2][1]["four"].Long());
+	ASSERT_EQ(5, doc[3].Long());
+}
+
+TEST(JVarTest, SmallValuesAreInline)
+{
+	ASSERT_EQ(16, sizeof(JVar));
+	
+	JVar small("fourteen chars"), large("more than fourteen chars");
+	ASSERT_EQ("fourteen chars", small.Str());
+	ASSERT_EQ("more than fourteen chars", large.Str());
+	ASSERT_EQ(std::string("more than fourteen chars"), large);
+	
+	JVar copy = large;
+	ASSERT_NE(large.Str().data(), copy.Str().data());
+	ASSERT_EQ(large.Str(), copy.Str());
+	
+	// empty containers are not allocated until they are modified
+	Arena arena;
+	JVar hash(Type::hash, &arena), array(Type::array, &arena);
+	ASSERT_EQ(0, hash.Size());
+	ASSERT_EQ(0, arena.Size());
+	ASSERT_EQ(&arena, hash.GetArena());
+	
+	array.Add(1).Add(large);
+	ASSERT_EQ(2, array.Size());
+	ASSERT_LT(0, arena.Size());
+	ASSERT_EQ(&arena, array.GetArena());
+	ASSERT_EQ(nullptr, array[1].GetArena());
+	
+	JVar str = JVar(Type::string, &arena);
+	ASSERT_TRUE(str.Str().empty());
+	ASSERT_THROW(str.AsArray(), int);
+}
+
+TEST(JVarTest, SharedValuesAreCopiedOnWrite)
+{
+	JVar config;
+	config.Add("name", "a string longer than 14 characters");
+	config.Add("list", JVar().Add(1).Add(2));
+	config.Add("nested", JVar().Add("key", "value"));
+	config.Share();
+	ASSERT_TRUE(config.IsShared());
+	ASSERT_TRUE(config["list"].IsShared());
+	
+	JVar copy = config;
+	const JVar& ccopy = copy;
+	const JVar& cconfig = config;
+	ASSERT_EQ(&cconfig.AsHash(), &ccopy.AsHash());
+	ASSERT_EQ(cconfig["name"].Str().data(), ccopy["name"].Str().data());
+	
+	// modifying the copy only copies the nodes on the path
+	copy["list"].Add(3);
+	ASSERT_NE(&cconfig.AsHash(), &ccopy.AsHash());
+	ASSERT_EQ(&cconfig["nested"].AsHash(), &ccopy["nested"].AsHash());
+	ASSERT_EQ(2, cconfig["list"].Size());
+	ASSERT_EQ(3, ccopy["list"].Size());
+	ASSERT_TRUE(copy["list"].IsShared());
+	
+	// no copy is made when there is no other reference
+	const JVar::Array *list = &ccopy["list"].AsArray();
+	copy["list"].Add(4);
+	ASSERT_EQ(list, &ccopy["list"].AsArray());
+	
+	// copies to an arena are deep
+	Arena arena;
+	JVar imported(cconfig, &arena);
+	ASSERT_FALSE(imported.IsShared());
+	ASSERT_EQ(&arena, imported["list"].GetArena());
+	ASSERT_EQ("value", imported["nested"]["key"].Str());
+}
+
+TEST(JVarTest, ShareAcrossThreads)
+{
+	JVar doc;
+	for (int i = 0 ; i < 100 ; ++i)
+		doc.Add(JVar().Add("id", i).Add("tag", "shared between threads"));
+	doc.Share();
+	
+	std::vector<std::thread> threads;
+	std::vector<long long> sums(4);
+	for (auto& sum : sums)
+		threads.emplace_back([&doc, &sum]
+		{
+			for (int round = 0 ; round < 100 ; ++round)
+			{
+				JVar copy = doc;
+				for (const auto& e : static_cast<const JVar&>(copy).AsArray())
+					sum += e["id"].Long();
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+	
+	for (auto sum : sums)
+		ASSERT_EQ(4950 * 100, sum);
+}
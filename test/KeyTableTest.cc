@@ -0,0 +1,113 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "KeyTable.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace json;
+
+// keys are views, so they cannot refer to temporary strings
+static_assert(!std::is_constructible<Key, std::string&&>::value, "Key binds to a temporary string");
+static_assert(std::is_constructible<Key, std::string&>::value, "Key cannot refer to a string");
+
+TEST(KeyTableTest, Find_keys_after_compile)
+{
+	std::vector<std::string> names;
+	for (int i = 0 ; i < 80 ; ++i)
+		names.push_back("field" + std::to_string(i));
+	
+	KeyTable sub;
+	for (std::size_t i = 0 ; i < names.size() ; ++i)
+		ASSERT_EQ(i, sub.Add(Key{names[i]}));
+	sub.Add(Key{3});
+	
+	sub.Compile();
+	ASSERT_TRUE(sub.IsCompiled());
+	
+	for (std::size_t i = 0 ; i < names.size() ; ++i)
+	{
+		std::string copy = names[i];
+		ASSERT_EQ(i, sub.Find(Key{copy}));
+	}
+	ASSERT_EQ(names.size(), sub.Find(Key{3}));
+	
+	ASSERT_EQ(KeyTable::npos, sub.Find(Key{"field80"}));
+	ASSERT_EQ(KeyTable::npos, sub.Find(Key{"fiel"}));
+	ASSERT_EQ(KeyTable::npos, sub.Find(Key{""}));
+	ASSERT_EQ(KeyTable::npos, sub.Find(Key{4}));
+}
+
+TEST(KeyTableTest, Add_existing_key_returns_same_ID)
+{
+	KeyTable sub;
+	ASSERT_EQ(0, sub.Add(Key{"abc"}));
+	ASSERT_EQ(1, sub.Add(Key{"def"}));
+	ASSERT_EQ(0, sub.Add(Key{"abc"}));
+	ASSERT_EQ(2, sub.Size());
+	
+	// linear search before compile
+	ASSERT_FALSE(sub.IsCompiled());
+	ASSERT_EQ(1, sub.Find(Key{"def"}));
+}
+
+TEST(KeyTableTest, Empty_table)
+{
+	KeyTable sub;
+	sub.Compile();
+	ASSERT_EQ(KeyTable::npos, sub.Find(Key{"abc"}));
+}
+
+TEST(KeyTableTest, Predictor_finds_keys_in_any_order)
+{
+	KeyTable table;
+	table.Add(Key{"kind"});
+	table.Add(Key{"id"});
+	table.Add(Key{"title"});
+	table.Compile();
+	
+	KeyPredictor sub;
+	for (int i = 0 ; i < 3 ; ++i)
+	{
+		sub.Restart();
+		ASSERT_EQ(0, sub.Find(table, Key{"kind"}));
+		ASSERT_EQ(1, sub.Find(table, Key{"id"}));
+		ASSERT_EQ(KeyTable::npos, sub.Find(table, Key{"etag"}));
+		ASSERT_EQ(2, sub.Find(table, Key{"title"}));
+	}
+	
+	// different order
+	sub.Restart();
+	ASSERT_EQ(2, sub.Find(table, Key{"title"}));
+	ASSERT_EQ(0, sub.Find(table, Key{"kind"}));
+	ASSERT_EQ(KeyTable::npos, sub.Find(table, Key{"kind1"}));
+	ASSERT_EQ(1, sub.Find(table, Key{"id"}));
+	
+	// another table
+	KeyTable table2;
+	table2.Add(Key{"id"});
+	table2.Compile();
+	ASSERT_EQ(0, sub.Find(table2, Key{"id"}));
+	ASSERT_EQ(KeyTable::npos, sub.Find(table2, Key{"kind"}));
+}
@@ -0,0 +1,147 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "LazyVar.hh"
+#include "JVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
+#include "Exception.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace json;
+
+TEST(LazyVarTest, ParseOnlyWhatIsRead)
+{
+	const char json[] =
+	" {"
+		"\"name\": \"Tom\\n\","
+		"\"age\" : 42 ,"
+		"\"height\": 1.75,"
+		"\"tags\": [\"a]\\\"\", [], {\"x\": [1, 2]}, null, true, false],"
+		"\"k\\u00e9y\": -7,"
+		"\"age\": 43"
+	"} ";
+	
+	LazyVar root(json, sizeof(json)-1);
+	ASSERT_FALSE(root.IsParsed());
+	ASSERT_TRUE(root.Is(Type::hash));
+	ASSERT_FALSE(root.IsParsed());
+	
+	ASSERT_EQ(6, root.Size());
+	ASSERT_TRUE(root.IsParsed());
+	ASSERT_EQ("Tom\n", root["name"].Str());
+	ASSERT_EQ(43, root["age"].Int());
+	ASSERT_EQ(-7, root["k\xc3\xa9y"].Long());
+	ASSERT_THROW(root["missing"], int);
+	ASSERT_THROW(root["age"].Str(), int);
+	ASSERT_THROW(root[0u], int);
+	
+	const LazyVar& tags = root["tags"];
+	ASSERT_FALSE(tags.IsParsed());
+	ASSERT_EQ(2, tags[2]["x"][1].Int());
+	ASSERT_EQ("a]\"", tags[0].Str());
+	ASSERT_FALSE(tags[1].IsParsed());
+	ASSERT_EQ(0, tags[1].Size());
+	ASSERT_TRUE(tags[3].IsNull());
+	ASSERT_TRUE(tags[4].Bool());
+	ASSERT_FALSE(tags[5].Bool());
+	ASSERT_THROW(tags[6], std::out_of_range);
+	ASSERT_FALSE(root["height"].IsParsed());
+	
+	std::vector<std::string> keys;
+	for (auto& m : root)
+		keys.push_back(m.first);
+	ASSERT_EQ((std::vector<std::string>{"name", "age", "height", "tags", "k\xc3\xa9y", "age"}), keys);
+	ASSERT_EQ("[1, 2]", tags[2]["x"].Raw());
+}
+
+TEST(LazyVarTest, ErrorsAreFoundWhenRead)
+{
+	const char json[] = "{\"a\": [1, 2,, 3],\n \"b\": tru, \"c\": \"ok\"}";
+	LazyDocument doc(json);
+	
+	ASSERT_EQ("ok", doc.Root()["c"].Str());
+	ASSERT_THROW(doc.Root()["b"].Bool(), ParseError);
+	ASSERT_THROW(doc.Root()["a"].Size(), ParseError);
+	ASSERT_THROW(doc.Root().ToJVar(), ParseError);
+	
+	try
+	{
+		LazyDocument bad("[1,\n 2 3]");
+		bad.Root().Size();
+		FAIL();
+	}
+	catch (ParseError& e)
+	{
+		ASSERT_EQ(1, e.Get<LineNumInfo>()->Value());
+		ASSERT_EQ(3, e.Get<ColumnNumInfo>()->Value());
+	}
+	
+	ASSERT_THROW(LazyDocument("{\"a\" 1}").Root().Size(), ParseError);
+	ASSERT_THROW(LazyDocument("[1] 2").Root().Size(), ParseError);
+	ASSERT_THROW(LazyDocument("\"abc").Root().Str(), ParseError);
+	ASSERT_TRUE(LazyVar().IsNull());
+	
+	// empty text and malformed numbers
+	ASSERT_THROW(LazyVar("", 0).Type(), ParseError);
+	ASSERT_THROW(LazyVar("  ", 2).Type(), ParseError);
+	ASSERT_THROW(LazyVar("1-2", 3).Type(), ParseError);
+	ASSERT_THROW(LazyVar("01", 2).Type(), ParseError);
+	ASSERT_THROW(LazyVar("1.", 2).Type(), ParseError);
+	ASSERT_THROW(LazyVar("+1", 2).Type(), ParseError);
+	ASSERT_THROW(LazyVar("1e", 2).Type(), ParseError);
+	ASSERT_EQ(-1500.0, LazyVar("-1.5e+3", 7).Real());
+	ASSERT_EQ(-7, LazyVar(" -7 ", 4).Int());
+}
+
+TEST(LazyVarTest, SameAsJVar)
+{
+	std::string json;
+	std::ifstream file(TEST_DATA "paddrive.json");
+	std::copy(
+		(std::istreambuf_iterator<char>(file)),
+		(std::istreambuf_iterator<char>()),
+		std::back_inserter(json));
+	
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h, 20);
+	sub.Parse(json.data(), json.size(), &var);
+	
+	LazyDocument doc(json);
+	const LazyVar& items = doc.Root()["items"];
+	ASSERT_EQ(var["items"].Size(), items.Size());
+	
+	for (std::size_t i = 0 ; i < items.Size() ; ++i)
+	{
+		ASSERT_EQ(var["items"][i]["id"].Str(), items[i]["id"].Str());
+		ASSERT_EQ(var["items"][i]["labels"]["starred"].Bool(), items[i]["labels"]["starred"].Bool());
+	}
+	
+	JVar copy = items[0].ToJVar(20);
+	ASSERT_EQ(var["items"][0].Size(), copy.Size());
+	ASSERT_EQ(var["items"][0]["title"].Str(), copy["title"].Str());
+}
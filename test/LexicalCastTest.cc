@@ -25,6 +25,13 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
 using namespace json;
 
 TEST(LexicalCastTest, Cast_integer)
@@ -41,7 +48,72 @@ TEST(LexicalCastTest, Cast_double)
 	ASSERT_EQ(123.123, LexicalCast<double>("123.123", 7) );
 }
 
+TEST(LexicalCastTest, Cast_integer_limits)
+{
+	ASSERT_EQ(std::numeric_limits<std::int64_t>::max(),  LexicalCast<std::int64_t>("9223372036854775807", 19));
+	ASSERT_EQ(std::numeric_limits<std::int64_t>::min(),  LexicalCast<std::int64_t>("-9223372036854775808", 20));
+	ASSERT_EQ(std::numeric_limits<std::uint64_t>::max(), LexicalCast<std::uint64_t>("18446744073709551615", 20));
+	ASSERT_EQ(4294967295U, LexicalCast<std::uint32_t>("4294967295", 10));
+	ASSERT_EQ(-2147483647-1, LexicalCast<std::int32_t>("-2147483648", 11));
+	ASSERT_EQ(12345678, LexicalCast<std::int32_t>("12345678.9", 10));
+	ASSERT_EQ(0, LexicalCast<std::int32_t>(nullptr, 0));
+	
+	ASSERT_THROW(LexicalCast<std::int64_t>("9223372036854775808", 19),   OutOfRange);
+	ASSERT_THROW(LexicalCast<std::uint64_t>("18446744073709551616", 20), OutOfRange);
+	ASSERT_THROW(LexicalCast<std::uint64_t>("100000000000000000000", 21), OutOfRange);
+	ASSERT_THROW(LexicalCast<std::uint32_t>("4294967296", 10), OutOfRange);
+	ASSERT_THROW(LexicalCast<std::uint32_t>("-1", 2), OutOfRange);
+	ASSERT_THROW(LexicalCast<std::int32_t>("2147483648", 10), OutOfRange);
+}
+
+TEST(LexicalCastTest, Cast_double_rounding)
+{
+	const char *cases[] =
+	{
+		"0", "-0.0", "1e-400", "4.9406564584124654e-324", "2.2250738585072011e-308",
+		"2.2250738585072014e-308", "1.7976931348623157e308", "9007199254740993",
+		"0.1", "3.141592653589793238462643383279", "123456789012345678901234567890",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"7.3177701707893310e+15", "5e-324", "2.47032822920623272e-324", "1e23",
+		"0.000000000000000000000000000000000000000000001", "-12.5E-3",
+	};
+	for (const char *str : cases)
+	{
+		std::size_t len = std::strlen(str);
+		ASSERT_EQ(std::strtod(str, nullptr), LexicalCast<double>(str, len)) << str;
+	}
+	
+	std::mt19937_64 gen(1234);
+	for (int i = 0 ; i < 10000 ; ++i)
+	{
+		std::uint64_t bits = gen() & 0x7FEFFFFFFFFFFFFFULL;
+		double d;
+		std::memcpy(&d, &bits, sizeof(d));
+		
+		char str[40];
+		int len = std::snprintf(str, sizeof(str), "%.*g", static_cast<int>(i % 17) + 1, d);
+		ASSERT_EQ(std::strtod(str, nullptr), LexicalCast<double>(str, static_cast<std::size_t>(len))) << str;
+	}
+	
+	ASSERT_THROW(LexicalCast<double>("1e400", 5), OutOfRange);
+	ASSERT_THROW(LexicalCast<double>("-1.8e308", 8), OutOfRange);
+}
+
+TEST(LexicalCastTest, Cast_bool)
+{
+	ASSERT_TRUE(LexicalCast<bool>("true", 4));
+	ASSERT_FALSE(LexicalCast<bool>("true", 3));
+	ASSERT_FALSE(LexicalCast<bool>("false", 5));
+	ASSERT_FALSE(LexicalCast<bool>(nullptr, 0));
+}
+
 TEST(LexicalCastTest, Unescape_normal)
 {
 	ASSERT_EQ("ABC\n",	Unescape("ABC\\n"));
 }
+
+TEST(LexicalCastTest, Unescape_unicode)
+{
+	ASSERT_EQ("a/\xc3\xa9\xe2\x82\xac",	Unescape("a\\/\\u00e9\\u20AC"));
+	ASSERT_EQ("\xf0\x9f\x98\x80",		Unescape("\\ud83d\\ude00"));
+}
@@ -0,0 +1,168 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include "JsonParser.hh"
+#include "JsonBuilder.hh"
+#include "MapBuilder.hh"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+using namespace json;
+
+namespace
+{
+	struct Metric
+	{
+		std::string	unit;
+		double		value;
+	};
+	
+	const JsonBuilder<Metric> metric_builder =
+	{
+		{"unit",  &Metric::unit},
+		{"value", &Metric::value}
+	};
+	
+	const char metrics[] =
+		"{"
+			"\"cpu\": {\"unit\": \"%\", \"value\": 42.5},"
+			"\"mem\": {\"unit\": \"MB\", \"value\": 1024},"
+			"\"disk\": {\"value\": 7}"
+		"}";
+}
+
+TEST(MapTest, MapOfObjects)
+{
+	struct Config
+	{
+		std::string name;
+		std::map<std::string, Metric> metrics;
+	};
+	
+	JsonBuilder<Config> h =
+	{
+		{"name",    &Config::name},
+		{"metrics", &Config::metrics, MapBuilder<Metric>(metric_builder)}
+	};
+	JsonParser sub(&h);
+	
+	std::string json = std::string("{\"name\": \"host1\", \"metrics\": ") + metrics + "}";
+	Config c;
+	sub.Parse(json.data(), json.size(), &c);
+	
+	ASSERT_EQ("host1", c.name);
+	ASSERT_EQ(3, c.metrics.size());
+	ASSERT_EQ("%",   c.metrics["cpu"].unit);
+	ASSERT_EQ(42.5,  c.metrics["cpu"].value);
+	ASSERT_EQ(1024,  c.metrics["mem"].value);
+	ASSERT_EQ(7,     c.metrics["disk"].value);
+}
+
+TEST(MapTest, UnorderedMapOfNumbers)
+{
+	using Map = std::unordered_map<std::string, int>;
+	MapBuilder<int, Map> h{SimpleTypeBuilder<int>()};
+	JsonParser sub(&h);
+	
+	const char json[] = "{\"a\": 1, \"b\": 2, \"a\": 3}";
+	Map m;
+	sub.Parse(json, sizeof(json)-1, &m);
+	
+	ASSERT_EQ((Map{{"a", 3}, {"b", 2}}), m);
+}
+
+TEST(MapTest, FlatMap)
+{
+	FlatMapBuilder<Metric> h{metric_builder};
+	JsonParser sub(&h);
+	
+	FlatMap<Metric> m;
+	sub.Parse(metrics, sizeof(metrics)-1, &m);
+	sub.Done();
+	
+	ASSERT_EQ(3, m.size());
+	ASSERT_EQ("cpu",  m[0].first);
+	ASSERT_EQ("disk", m[1].first);
+	ASSERT_EQ("mem",  m[2].first);
+	ASSERT_EQ("MB",   FlatMapFind(m, "mem")->unit);
+	ASSERT_EQ(nullptr, FlatMapFind(m, "net"));
+	
+	const char dup[] = "{\"b\": {\"value\": 1}, \"a\": {\"value\": 2}, \"b\": {\"value\": 3}}";
+	FlatMap<Metric> d;
+	sub.Parse(dup, sizeof(dup)-1, &d);
+	ASSERT_EQ(2, d.size());
+	ASSERT_EQ(3, FlatMapFind(d, "b")->value);
+}
+
+TEST(MapTest, WriteMaps)
+{
+	MapBuilder<Metric> h{metric_builder};
+	JsonParser sub(&h);
+	
+	std::map<std::string, Metric> m;
+	sub.Parse(metrics, sizeof(metrics)-1, &m);
+	sub.Done();
+	m["a\tb"].value = -1;
+	
+	std::string json;
+	Writer out(json);
+	Serialize(h, m, out);
+	ASSERT_EQ(
+		"{"
+			"\"a\\tb\":{\"unit\":\"\",\"value\":-1.0},"
+			"\"cpu\":{\"unit\":\"%\",\"value\":42.5},"
+			"\"disk\":{\"unit\":\"\",\"value\":7.0},"
+			"\"mem\":{\"unit\":\"MB\",\"value\":1024.0}"
+		"}", json);
+	
+	FlatMapBuilder<int> fh{SimpleTypeBuilder<int>()};
+	json.clear();
+	Serialize(fh, FlatMap<int>{{"x", 1}, {"y", -2}}, out);
+	ASSERT_EQ("{\"x\":1,\"y\":-2}", json);
+}
+
+TEST(MapTest, EscapedKeys)
+{
+	const char json[] = "{\"a\\\"b\": 1, \"c\\\\d\": 2, \"e\": 3}";
+	
+	MapBuilder<int> h{SimpleTypeBuilder<int>()};
+	JsonParser sub(&h);
+	std::map<std::string, int> m;
+	sub.Parse(json, sizeof(json)-1, &m);
+	sub.Done();
+	ASSERT_EQ((std::map<std::string, int>{{"a\"b", 1}, {"c\\d", 2}, {"e", 3}}), m);
+	
+	FlatMapBuilder<int> fh{SimpleTypeBuilder<int>()};
+	JsonParser fsub(&fh);
+	FlatMap<int> f;
+	fsub.Parse(json, sizeof(json)-1, &f);
+	fsub.Done();
+	ASSERT_EQ((FlatMap<int>{{"a\"b", 1}, {"c\\d", 2}, {"e", 3}}), f);
+	
+	// the keys are escaped only once when written back
+	std::string out;
+	Writer w(out);
+	Serialize(h, m, w);
+	ASSERT_EQ("{\"a\\\"b\":1,\"c\\\\d\":2,\"e\":3}", out);
+}
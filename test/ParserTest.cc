@@ -22,8 +22,14 @@
 
 #include "JsonParser.hh"
 #include "JsonBuilder.hh"
+#include "JVarBuilder.hh"
+#include "TapeBuilder.hh"
 
+#include <unistd.h>
+
+#include <cstdlib>
 #include <iterator>
+#include <string>
 #include <fstream>
 
 using namespace json;
@@ -48,6 +54,42 @@ TEST(ParserTest, Test1Level)
 	ASSERT_EQ(321.0,   staff.age);
 }
 
+TEST(ParserTest, CompileAfterAdd)
+{
+	struct Person
+	{
+		std::string name;
+		double      age;
+		int         id;
+	};
+	
+	JsonBuilder<Person> h;
+	h.Add("name", &Person::name);
+	h.Add("age",  &Person::age);
+	h.Add("id",   &Person::id);
+	ASSERT_FALSE(h.IsCompiled());
+	
+	const char json[] = "{\"id\": 7, \"name\": \"Mary\", \"age\": 70}";
+	
+	// keys are looked up linearly before compiling
+	Person p1{"", 0, 0};
+	JsonParser sub(&h);
+	sub.Parse(json, sizeof(json)-1, &p1);
+	sub.Done();
+	ASSERT_EQ("Mary", p1.name);
+	ASSERT_EQ(7, p1.id);
+	
+	h.Compile();
+	ASSERT_TRUE(h.IsCompiled());
+	
+	Person p2{"", 0, 0};
+	sub.Parse(json, sizeof(json)-1, &p2);
+	sub.Done();
+	ASSERT_EQ("Mary", p2.name);
+	ASSERT_EQ(70.0, p2.age);
+	ASSERT_EQ(7, p2.id);
+}
+
 TEST(ParserTest, Test2Level)
 {
 	struct Person
@@ -138,13 +180,6 @@ TEST(ParserTest, TestComplexClass)
 
 TEST(ParserTest, GoogleDriveListTest)
 {
-	std::string json;
-	std::ifstream test_file(TEST_DATA "paddrive.json");
-	std::copy(
-		(std::istreambuf_iterator<char>(test_file)),
-		(std::istreambuf_iterator<char>()),
-		std::back_inserter(json));
-
 	struct Label
 	{
 		bool starred;
@@ -174,8 +209,253 @@ TEST(ParserTest, GoogleDriveListTest)
 	
 	FileList list;
 	list.labels.starred = true;
-	sub.Parse(json.data(), json.size(), &list);
+	sub.ParseFile(TEST_DATA "paddrive.json", &list);
 	
 	ASSERT_EQ(list.kind, "drive#fileList");
 //	ASSERT_FALSE(list.labels.starred);
 }
+
+TEST(ParserTest, ParseFileNotFound)
+{
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h);
+	
+	try
+	{
+		sub.ParseFile(TEST_DATA "no-such-file.json", &var);
+		FAIL();
+	}
+	catch (FileError& e)
+	{
+		ASSERT_EQ(TEST_DATA "no-such-file.json", e.Get<FileNameInfo>()->Value());
+		ASSERT_NE(0, e.Get<ErrnoInfo>()->Value());
+	}
+}
+
+TEST(ParserTest, ParseFileTruncated)
+{
+	char path[] = "/tmp/autojson-XXXXXX";
+	int fd = ::mkstemp(path);
+	ASSERT_NE(-1, fd);
+	
+	const char json[] = "{\"name\":\"a\",\"n\":";
+	ASSERT_EQ(static_cast<long>(sizeof(json)-1), ::write(fd, json, sizeof(json)-1));
+	::close(fd);
+	
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h);
+	ASSERT_THROW(sub.ParseFile(path, &var), ParseError);
+	::unlink(path);
+	
+	// the parser is ready for the next document
+	JVar next;
+	const char whole[] = "{\"n\":1}";
+	sub.Parse(whole, sizeof(whole)-1, &next);
+	ASSERT_TRUE(sub.Done());
+	ASSERT_EQ(1, next["n"].Int());
+}
+
+TEST(ParserTest, ParseFileFromPipe)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+	
+	// the size of a pipe is zero, so it cannot be mapped
+	const char json[] = "{\"name\": \"Isis\", \"age\": 5}";
+	ASSERT_EQ(static_cast<long>(sizeof(json)-1), ::write(fds[1], json, sizeof(json)-1));
+	::close(fds[1]);
+	
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h);
+	sub.ParseFile("/dev/fd/" + std::to_string(fds[0]), &var);
+	::close(fds[0]);
+	
+	ASSERT_EQ("Isis", var["name"].Str());
+	ASSERT_EQ(5, var["age"].Int());
+}
+
+TEST(ParserTest, KeyAndValueInDifferentChunks)
+{
+	struct Person
+	{
+		std::string name;
+		int			age;
+	};
+	
+	JsonBuilder<Person> h =
+	{
+		{"name", &Person::name},
+		{"age",  &Person::age}
+	};
+	JsonParser sub(&h);
+	
+	Person p{"", 0};
+	sub.SetTarget(&p);
+	
+	// the buffer holding the key is gone before its value comes
+	std::string js1 = "{\"name\": \"Peter\", \"age\"";
+	std::string js2 = ": 42}";
+	sub.Parse(js1.data(), js1.size());
+	js1.assign(js1.size(), 'x');
+	sub.Parse(js2.data(), js2.size());
+	
+	ASSERT_EQ("Peter", p.name);
+	ASSERT_EQ(42, p.age);
+}
+
+namespace
+{
+	// records the keys of the objects given to Finish()
+	struct FinishedKeys : public JsonProcessor
+	{
+		using Keys = std::vector<std::string>;
+		
+		void Data(const Cursor&, JSON_event, const char*, size_t) const override
+		{
+		}
+		
+		Cursor Advance(const Cursor& current) const override
+		{
+			return Cursor{current.Key(), current.Target<Keys>(), this};
+		}
+		
+		void Finish(const Cursor& current) const override
+		{
+			if (current.Key().IsKey())
+				current.Target<Keys>()->push_back(current.Key().Str());
+		}
+	};
+}
+
+TEST(ParserTest, KeysOfUnfinishedObjectsAcrossChunks)
+{
+	FinishedKeys h;
+	JsonParser sub(&h);
+	
+	FinishedKeys::Keys keys;
+	sub.SetTarget(&keys);
+	
+	// the first chunk is overwritten before the objects end
+	std::string chunk = "{\"outer_key_xyz\":{\"inner\":{\"a\":1";
+	sub.Parse(chunk.data(), chunk.size());
+	chunk.assign(chunk.size(), ' ');
+	
+	const char end[] = "}}}";
+	sub.Parse(end, sizeof(end)-1);
+	sub.Done();
+	
+	ASSERT_EQ((FinishedKeys::Keys{"inner", "outer_key_xyz"}), keys);
+}
+
+TEST(ParserTest, StringViewRefersToInput)
+{
+	struct Request
+	{
+		std::string	method;
+		StringView	path;
+	};
+	
+	JsonBuilder<Request> h =
+	{
+		{"method", &Request::method},
+		{"path",   &Request::path}
+	};
+	JsonParser sub(&h);
+	
+	Request r;
+	r.method.reserve(100);
+	const char *buf = r.method.data();
+	
+	const char json[] = "{\"method\": \"GET\", \"path\": \"/index.html\"}";
+	sub.Parse(json, sizeof(json)-1, &r);
+	
+	ASSERT_EQ("GET", r.method);
+	ASSERT_EQ(buf, r.method.data());
+	ASSERT_EQ("/index.html", std::string(r.path.begin(), r.path.end()));
+	ASSERT_TRUE(r.path.begin() >= json && r.path.end() <= json + sizeof(json));
+}
+
+TEST(ParserTest, WriteWithBuilder)
+{
+	struct Person
+	{
+		std::string	name;
+		double		age;
+		bool		alive;
+	};
+	
+	JsonBuilder<Person> h =
+	{
+		{"name",  &Person::name},
+		{"age",   &Person::age},
+		{"alive", &Person::alive}
+	};
+	
+	Person p{"Tom \"Jr\"\n", 12.5, true};
+	std::string json;
+	Writer out(json);
+	Serialize(h, p, out);
+	ASSERT_EQ("{\"name\":\"Tom \\\"Jr\\\"\\n\",\"age\":12.5,\"alive\":true}", json);
+	
+	// the strings of the members are unescaped, so they come back as written
+	Person copy{};
+	JsonParser sub(&h);
+	sub.Parse(json.data(), json.size(), &copy);
+	sub.Done();
+	ASSERT_EQ(p.name, copy.name);
+	ASSERT_EQ(p.age, copy.age);
+	
+	std::string again;
+	Writer out_again(again);
+	Serialize(h, copy, out_again);
+	ASSERT_EQ(json, again);
+	
+	// keys are given in their escaped form, which is matched and written as it is
+	const char quoted[] = "{\"\\\"quoted\\\"\":12.5}";
+	JsonBuilder<Person> escaped{"\\\"quoted\\\"", &Person::age};
+	Person q{};
+	JsonParser esub(&escaped);
+	esub.Parse(quoted, sizeof(quoted)-1, &q);
+	esub.Done();
+	ASSERT_EQ(12.5, q.age);
+	
+	json.clear();
+	Serialize(escaped, q, out);
+	ASSERT_EQ(quoted, json);
+}
+
+TEST(ParserTest, WriteDynamicMembers)
+{
+	struct Dynamic
+	{
+		JVar	var;
+		Tape	tape;
+		int		n;
+	};
+	
+	JsonBuilder<Dynamic> h
+	{
+		{"var",  &Dynamic::var,  JVarBuilder()},
+		{"tape", &Dynamic::tape, TapeBuilder()},
+		{"n",    &Dynamic::n}
+	};
+	
+	const char json[] =
+		"{\"var\":{\"x\":[1,2.5,\"a\\\"b\"],\"y\":null},"
+		"\"tape\":{\"x\":[1,2.5,\"a\\\"b\"],\"y\":true},"
+		"\"n\":3}";
+	
+	Dynamic d;
+	d.n = 0;
+	JsonParser sub(&h);
+	sub.Parse(json, sizeof(json)-1, &d);
+	sub.Done();
+	
+	std::string result;
+	Writer out(result);
+	Serialize(h, d, out);
+	ASSERT_EQ(json, result);
+}
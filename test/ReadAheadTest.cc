@@ -0,0 +1,145 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include "ReadAhead.hh"
+#include "Automaton.hh"
+#include "JsonParser.hh"
+#include "JVarBuilder.hh"
+#include "MappedFile.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace json;
+
+TEST(ReadAheadTest, ChunksInOrder)
+{
+	MappedFile expect(TEST_DATA "paddrive.json");
+
+	int fd = ::open(TEST_DATA "paddrive.json", O_RDONLY);
+	ASSERT_GE(fd, 0);
+
+	std::string actual;
+	{
+		ReadAhead input(fd, 100, 3);
+
+		const char *data;
+		std::size_t len;
+		while (input.Next(data, len))
+		{
+			ASSERT_LE(len, 100);
+			actual.append(data, len);
+		}
+		ASSERT_FALSE(input.Next(data, len));
+	}
+	::close(fd);
+
+	ASSERT_EQ(std::string(expect.Data(), expect.Size()), actual);
+}
+
+TEST(ReadAheadTest, FeedParserFromPipe)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+
+	// each write may end in the middle of a token
+	std::thread writer([&fds]
+	{
+		const char json[] = "{\"name\": \"Isis\", \"tags\": [\"cat\", \"dog\"], \"age\": 5.1}";
+		for (std::size_t i = 0 ; i < sizeof(json)-1 ; i += 7)
+		{
+			std::size_t len = std::min<std::size_t>(7, sizeof(json)-1-i);
+			ASSERT_EQ(static_cast<long>(len), ::write(fds[1], json + i, len));
+		}
+		::close(fds[1]);
+	});
+
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h);
+	sub.SetTarget(&var);
+	{
+		ReadAhead input(fds[0], 16);
+		input.Feed(sub);
+	}
+	writer.join();
+	::close(fds[0]);
+
+	ASSERT_EQ("Isis", var["name"].Str());
+	ASSERT_EQ(2, var["tags"].Size());
+	ASSERT_EQ("dog", var["tags"][1].Str());
+	ASSERT_EQ(5.1, var["age"].Real());
+}
+
+TEST(ReadAheadTest, TokenLongerThanChunk)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+
+	// the string spans three chunks and the parser saves it in between
+	const std::string text(3000, 'x');
+	const std::string json = "{\"text\": \"" + text + "\", \"n\": 12345}";
+	std::thread writer([&fds, &json]
+	{
+		ASSERT_EQ(static_cast<long>(json.size()), ::write(fds[1], json.data(), json.size()));
+		::close(fds[1]);
+	});
+
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h);
+	sub.SetTarget(&var);
+	{
+		ReadAhead input(fds[0], 1024);
+		input.Feed(sub);
+	}
+	writer.join();
+	::close(fds[0]);
+
+	ASSERT_TRUE(sub.Done());
+	ASSERT_EQ(text, var["text"].Str());
+	ASSERT_EQ(12345, var["n"].Int());
+}
+
+TEST(ReadAheadTest, ReadError)
+{
+	// reading a directory fails with EISDIR
+	int fd = ::open(TEST_DATA, O_RDONLY);
+	ASSERT_GE(fd, 0);
+
+	Automaton sub([](Event, DataType, const char*, std::size_t){});
+	ReadAhead input(fd);
+	try
+	{
+		input.Feed(sub);
+		FAIL();
+	}
+	catch (FileError& e)
+	{
+		ASSERT_EQ(EISDIR, e.Get<ErrnoInfo>()->Value());
+	}
+	::close(fd);
+}
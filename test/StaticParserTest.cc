@@ -0,0 +1,193 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include "StaticParser.hh"
+#include "Exception.hh"
+#include "MappedFile.hh"
+
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace json;
+
+namespace
+{
+	struct Person
+	{
+		std::string name;
+		double		age;
+	};
+	
+	struct Book
+	{
+		std::string 		title;
+		Person				author;
+		std::size_t			pages;
+		bool				published;
+		std::vector<int>	ratings;
+		std::deque<Person>	reviewers;
+	};
+	
+	const auto person_schema = MakeObject<Person>(
+		MakeMember("name", &Person::name),
+		MakeMember("age",  &Person::age)
+	);
+	
+	const auto book_schema = MakeObject<Book>(
+		MakeMember("title",		&Book::title),
+		MakeMember("author",	&Book::author, person_schema),
+		MakeMember("pages",		&Book::pages),
+		MakeMember("published",	&Book::published),
+		MakeMember("ratings",	&Book::ratings),
+		MakeMember("reviewers",	&Book::reviewers, MakeArray(person_schema))
+	);
+}
+
+TEST(StaticParserTest, NestedObjectsAndArrays)
+{
+	const char json[] =
+	"{"
+		"\"title\": \"Pride and Prejudices\","
+		"\"unknown\": {\"a\": [1, {\"b\": null}], \"c\": \"d\"},"
+		"\"author\": {\"name\": \"John\", \"age\": 25.2},"
+		"\"pages\": 100,"
+		"\"published\": true,"
+		"\"ratings\": [5, 4, -3],"
+		"\"reviewers\": [{\"name\": \"Mary\"}, {\"age\": 70, \"name\": \"Tom\\n\\u00e9\"}]"
+	"}";
+	
+	auto sub = MakeStaticParser(book_schema);
+	
+	Book b{};
+	sub.Parse(json, sizeof(json)-1, &b);
+	
+	ASSERT_EQ("Pride and Prejudices", b.title);
+	ASSERT_EQ("John", b.author.name);
+	ASSERT_EQ(25.2,   b.author.age);
+	ASSERT_EQ(100,    b.pages);
+	ASSERT_TRUE(b.published);
+	ASSERT_EQ((std::vector<int>{5, 4, -3}), b.ratings);
+	ASSERT_EQ(2, b.reviewers.size());
+	ASSERT_EQ("Mary", b.reviewers[0].name);
+	ASSERT_EQ("Tom\n\xc3\xa9", b.reviewers[1].name);
+	ASSERT_EQ(70, b.reviewers[1].age);
+}
+
+TEST(StaticParserTest, StringView)
+{
+	struct Header
+	{
+		StringView	name;
+		StringView	value;
+	};
+	const auto schema = MakeObject<Header>(
+		MakeMember("name",  &Header::name),
+		MakeMember("value", &Header::value)
+	);
+	
+	const char json[] = "{\"name\": \"Host\", \"value\": \"a\\\"b\"}";
+	
+	Header h{};
+	MakeStaticParser(schema).Parse(json, sizeof(json)-1, &h);
+	
+	ASSERT_EQ(json + 10, h.name.begin());
+	ASSERT_EQ("Host", std::string(h.name.begin(), h.name.end()));
+	
+	// not unescaped
+	ASSERT_EQ("a\\\"b", std::string(h.value.begin(), h.value.end()));
+}
+
+TEST(StaticParserTest, MismatchedValuesAreSkipped)
+{
+	const char json[] = "{\"title\": [1, 2], \"author\": \"nobody\", \"ratings\": null, \"pages\": 7}";
+	
+	StaticParser<decltype(book_schema)> sub(book_schema);
+	
+	Book b{};
+	b.title = "none";
+	sub.Parse(json, sizeof(json)-1, &b);
+	ASSERT_EQ("none", b.title);
+	ASSERT_TRUE(b.ratings.empty());
+	ASSERT_EQ(7, b.pages);
+}
+
+TEST(StaticParserTest, InvalidJsonThrows)
+{
+	auto sub = MakeStaticParser(person_schema);
+	Person p{};
+	
+	const char *invalid[] =
+	{
+		"{\"name\": \"abc\"",
+		"{\"name\": \"abc\",}",
+		"{\"name\" \"abc\"}",
+		"{\"age\": 01}",
+		"{\"age\": 1.}",
+		"{\"name\": tru}",
+		"{\"name\": \"a\\q\"}",
+		"{} {}",
+		"[[[[[[[[[[[[1]]]]]]]]]]]]",
+	};
+	for (auto js : invalid)
+		ASSERT_THROW(sub.Parse(js, std::strlen(js), &p), ParseError) << js;
+}
+
+TEST(StaticParserTest, ErrorLocation)
+{
+	auto sub = MakeStaticParser(person_schema);
+	Person p{};
+	
+	const char json[] = "{\n\"name\": \"abc\",\n  \"age\": x\n}";
+	try
+	{
+		sub.Parse(json, sizeof(json)-1, &p);
+		FAIL();
+	}
+	catch (ParseError& e)
+	{
+		ASSERT_EQ(2, e.Get<LineNumInfo>()->Value());
+		ASSERT_EQ(9, e.Get<ColumnNumInfo>()->Value());
+	}
+}
+
+TEST(StaticParserTest, GoogleDriveListTest)
+{
+	MappedFile json(TEST_DATA "paddrive.json");
+	
+	struct FileList
+	{
+		std::string kind;
+		std::string etag;
+	};
+	
+	auto sub = MakeStaticParser(MakeObject<FileList>(
+		MakeMember("kind", &FileList::kind),
+		MakeMember("etag", &FileList::etag)
+	), 20);
+	
+	FileList list;
+	sub.Parse(json.Data(), json.Size(), &list);
+	ASSERT_EQ("drive#fileList", list.kind);
+	ASSERT_FALSE(list.etag.empty());
+}
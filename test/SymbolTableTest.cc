@@ -0,0 +1,134 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "SymbolTable.hh"
+#include "KeyTable.hh"
+#include "JVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace json;
+
+TEST(SymbolTableTest, Intern_returns_same_ID)
+{
+	SymbolTable sub;
+	ASSERT_EQ(0, sub.Intern("kind", 4));
+	ASSERT_EQ(1, sub.Intern("etag", 4));
+	ASSERT_EQ(0, sub.Intern("kind", 4));
+	ASSERT_EQ(2, sub.Intern("", 0));
+	ASSERT_EQ(3, sub.Size());
+	
+	ASSERT_EQ("etag", sub.Name(1));
+	ASSERT_EQ(KeyTable::Hash("etag", 4, 0), sub.Hash(1));
+	ASSERT_EQ(1, sub.Find("etag", 4));
+	ASSERT_EQ(SymbolTable::npos, sub.Find("selfLink", 8));
+}
+
+TEST(SymbolTableTest, Stop_adding_at_limit)
+{
+	SymbolTable sub(2);
+	ASSERT_EQ(0, sub.Intern("a", 1));
+	ASSERT_EQ(1, sub.Intern("b", 1));
+	ASSERT_EQ(SymbolTable::npos, sub.Intern("c", 1));
+	ASSERT_EQ(1, sub.Intern("b", 1));
+}
+
+TEST(SymbolTableTest, Intern_from_many_threads)
+{
+	const int count = 2000;
+	SymbolTable sub;
+	
+	std::vector<std::vector<std::uint32_t>> ids(4);
+	std::vector<std::thread> threads;
+	for (auto& result : ids)
+		threads.emplace_back([&sub, &result, count]
+		{
+			for (int i = 0 ; i < count ; ++i)
+			{
+				std::string name = "field" + std::to_string(i);
+				result.push_back(sub.Intern(name.data(), name.size()));
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+	
+	ASSERT_EQ(count, sub.Size());
+	for (auto& result : ids)
+		ASSERT_EQ(ids.front(), result);
+	for (int i = 0 ; i < count ; ++i)
+		ASSERT_EQ("field" + std::to_string(i), sub.Name(ids.front()[i]));
+}
+
+TEST(SymbolTableTest, Symbols_are_keys)
+{
+	Key sym = Key{"selfLink"}.Intern();
+	ASSERT_TRUE(sym.IsSymbol());
+	ASSERT_TRUE(sym.IsKey());
+	ASSERT_EQ("selfLink", sym.Str());
+	
+	ASSERT_EQ(sym, Key{"selfLink"}.Intern());
+	ASSERT_EQ(sym, Key{"selfLink"});
+	ASSERT_EQ(Key{"selfLink"}, sym);
+	ASSERT_NE(sym, Key{"kind"}.Intern());
+	ASSERT_TRUE(Key{"kind"}.Intern() < sym);
+	ASSERT_TRUE(sym < Key{0});
+	ASSERT_EQ(Key{5}, Key{5}.Intern());
+	
+	KeyTable table;
+	table.Add(Key{"kind"});
+	table.Add(Key{"selfLink"});
+	table.Compile();
+	ASSERT_EQ(1, table.Find(sym));
+}
+
+TEST(SymbolTableTest, Parse_with_interned_keys)
+{
+	const char json[] = "{\"kind\": \"drive#file\", \"ta\\u0067s\": [{\"kind\": 1}]}";
+	
+	JVarBuilder h(nullptr, true);
+	JsonParser sub(&h);
+	
+	JVar doc1, doc2;
+	sub.Parse(json, sizeof(json)-1, &doc1);
+	sub.Done();
+	sub.Parse(json, sizeof(json)-1, &doc2);
+	sub.Done();
+	
+	Key kind = Key{"kind"}.Intern();
+	const auto& hash = doc1.AsHash();
+	ASSERT_TRUE(hash.begin()->first.IsSymbol());
+	ASSERT_EQ(kind.SymbolId(), hash.begin()->first.SymbolId());
+	ASSERT_EQ("drive#file", hash.at(kind).Str());
+	ASSERT_EQ("drive#file", hash.at(Key{"kind"}).Str());
+	ASSERT_EQ(1, doc2["tags"][0].AsHash().at(kind).Long());
+	
+	// interned keys share the same string
+	ASSERT_EQ(hash.begin()->first.data(), doc2.AsHash().begin()->first.data());
+	
+	JVar copy = doc1;
+	ASSERT_EQ(1, copy.AsHash().count(kind));
+	ASSERT_TRUE(copy.AsHash().begin()->first.IsSymbol());
+}
@@ -0,0 +1,132 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Tape.hh"
+#include "TapeBuilder.hh"
+#include "JVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace json;
+
+TEST(TapeTest, Navigate)
+{
+	const char json[] =
+	"{"
+		"\"name\": \"Tom\\n\","
+		"\"age\": 42,"
+		"\"height\": 1.75,"
+		"\"tags\": [\"a\", [], {\"x\": [1, 2]}, null, true, false],"
+		"\"k\\u00e9y\": -7"
+	"}";
+	
+	Tape tape;
+	TapeBuilder h;
+	JsonParser sub(&h);
+	sub.Parse(json, sizeof(json)-1, &tape);
+	sub.Done();
+	
+	TapeView root = tape.Root();
+	ASSERT_TRUE(root.Is(Type::hash));
+	ASSERT_EQ(5, root.Size());
+	ASSERT_EQ("Tom\n", root["name"].Str());
+	ASSERT_EQ(42, root["age"].Long());
+	ASSERT_EQ(1.75, root["height"].Real());
+	ASSERT_EQ(-7, root["k\xc3\xa9y"].Int());
+	ASSERT_THROW(root["age"].Str(), int);
+	ASSERT_THROW(root["missing"], int);
+	ASSERT_EQ(root.end(), root.Find(StringView{}));
+	
+	TapeView tags = root["tags"];
+	ASSERT_EQ(6, tags.Size());
+	ASSERT_EQ("a", tags[0].Str());
+	ASSERT_EQ(0, tags[1].Size());
+	ASSERT_EQ(2, tags[2]["x"][1].Long());
+	ASSERT_TRUE(tags[3].IsNull());
+	ASSERT_TRUE(tags[4].Bool());
+	ASSERT_FALSE(tags[5].Bool());
+	ASSERT_THROW(tags[6], std::out_of_range);
+	
+	std::vector<std::string> keys;
+	for (auto it = root.begin() ; it != root.end() ; ++it)
+		keys.push_back(it.Key().Str());
+	ASSERT_EQ((std::vector<std::string>{"name", "age", "height", "tags", "k\xc3\xa9y"}), keys);
+	
+	// the whole tags array is skipped by one step
+	auto it = root.Find(StringView{keys[3].data(), keys[3].data() + keys[3].size()});
+	ASSERT_EQ("k\xc3\xa9y", (++it).Key());
+}
+
+TEST(TapeTest, SameAsJVar)
+{
+	std::string json;
+	std::ifstream file(TEST_DATA "paddrive.json");
+	std::copy(
+		(std::istreambuf_iterator<char>(file)),
+		(std::istreambuf_iterator<char>()),
+		std::back_inserter(json));
+	
+	Tape tape;
+	TapeBuilder th;
+	JsonParser tsub(&th, 20);
+	
+	// parsing again reuses the tape
+	for (int i = 0 ; i < 2 ; ++i)
+	{
+		tsub.Parse(json.data(), json.size(), &tape);
+		tsub.Done();
+	}
+	
+	JVar var;
+	JVarBuilder vh;
+	JsonParser vsub(&vh, 20);
+	vsub.Parse(json.data(), json.size(), &var);
+	
+	const JVar& items = var["items"];
+	TapeView titems = tape.Root()["items"];
+	ASSERT_EQ(items.Size(), titems.Size());
+	ASSERT_EQ(var.Size(), tape.Root().Size());
+	
+	std::size_t i = 0;
+	for (auto item : titems)
+	{
+		ASSERT_EQ(items[i]["id"].Str(), item["id"].Str());
+		ASSERT_EQ(items[i]["labels"].Size(), item["labels"].Size());
+		ASSERT_EQ(items[i]["labels"]["starred"].Bool(), item["labels"]["starred"].Bool());
+		++i;
+	}
+	ASSERT_EQ(items.Size(), i);
+}
+
+TEST(TapeTest, EmptyTapeIsNull)
+{
+	Tape tape;
+	ASSERT_TRUE(tape.Empty());
+	ASSERT_TRUE(tape.Root().IsNull());
+	ASSERT_EQ(0, tape.Root().Size());
+	ASSERT_EQ(tape.Root().begin(), tape.Root().end());
+}
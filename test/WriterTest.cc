@@ -0,0 +1,247 @@
+/*
+	autojson: A JSON parser base on the automaton provided by json.org
+	Copyright (C) 2015  Wan Wai Ho
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation version 2
+	of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+	02110-1301, USA.
+*/
+
+#include "Writer.hh"
+#include "JVar.hh"
+#include "JVarBuilder.hh"
+#include "JsonParser.hh"
+#include "LexicalCast.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace json;
+
+namespace
+{
+	std::string Int(long long val)
+	{
+		char buf[max_int_size];
+		return std::string(buf, FormatInt(val, buf));
+	}
+
+	std::string Real(double val)
+	{
+		char buf[max_real_size];
+		return std::string(buf, FormatReal(val, buf));
+	}
+}
+
+TEST(WriterTest, Integers)
+{
+	ASSERT_EQ("0", Int(0));
+	ASSERT_EQ("7", Int(7));
+	ASSERT_EQ("-10", Int(-10));
+	ASSERT_EQ("1234567890123", Int(1234567890123LL));
+	ASSERT_EQ("9223372036854775807", Int(std::numeric_limits<long long>::max()));
+	ASSERT_EQ("-9223372036854775808", Int(std::numeric_limits<long long>::min()));
+}
+
+TEST(WriterTest, Reals)
+{
+	ASSERT_EQ("0.0", Real(0.0));
+	ASSERT_EQ("-0.0", Real(-0.0));
+	ASSERT_EQ("1.0", Real(1.0));
+	ASSERT_EQ("-42.0", Real(-42.0));
+	ASSERT_EQ("0.1", Real(0.1));
+	ASSERT_EQ("0.3", Real(0.3));
+	ASSERT_EQ("0.30000000000000004", Real(0.1 + 0.2));
+	ASSERT_EQ("123456.789", Real(123456.789));
+	ASSERT_EQ("9007199254740992.0", Real(9007199254740992.0));
+	ASSERT_EQ("100000000000000000000.0", Real(1e20));
+	ASSERT_EQ("1e21", Real(1e21));
+	ASSERT_EQ("0.000001", Real(1e-6));
+	ASSERT_EQ("1e-7", Real(1e-7));
+	ASSERT_EQ("1.7976931348623157e308", Real(std::numeric_limits<double>::max()));
+	ASSERT_EQ("2.2250738585072014e-308", Real(std::numeric_limits<double>::min()));
+	ASSERT_EQ("5e-324", Real(std::numeric_limits<double>::denorm_min()));
+	ASSERT_EQ("null", Real(std::numeric_limits<double>::quiet_NaN()));
+	ASSERT_EQ("null", Real(-std::numeric_limits<double>::infinity()));
+}
+
+TEST(WriterTest, RealsAreShortestRoundTrip)
+{
+	std::mt19937_64 rand(42);
+	for (int i = 0 ; i < 20000 ; ++i)
+	{
+		std::uint64_t bits = rand();
+		double val;
+		std::memcpy(&val, &bits, sizeof(val));
+		if (!std::isfinite(val))
+			continue;
+		
+		std::string str = Real(val);
+		ASSERT_EQ(val, LexicalCast<double>(str.data(), str.size())) << str;
+		
+		// no fewer significant digits convert back to the same double
+		std::string digits = str.substr(0, str.find('e'));
+		digits.erase(std::remove_if(digits.begin(), digits.end(), [](char c) { return c == '-' || c == '.'; }), digits.end());
+		digits = digits.substr(digits.find_first_not_of('0'));
+		digits.erase(digits.find_last_not_of('0') + 1);
+		if (digits.size() < 2)
+			continue;
+		
+		char shorter[32];
+		std::snprintf(shorter, sizeof(shorter), "%.*e", static_cast<int>(digits.size()) - 2, val);
+		ASSERT_NE(val, std::strtod(shorter, nullptr)) << str;
+	}
+}
+
+TEST(WriterTest, EscapeStrings)
+{
+	std::string json;
+	Writer w(json);
+	
+	w.String("plain", 5);
+	ASSERT_EQ("\"plain\"", json);
+	
+	json.clear();
+	const char raw[] = "a\"b\\c/\b\f\n\r\t\x01\x1f\xc3\xa9";
+	w.String(raw, sizeof(raw) - 1);
+	ASSERT_EQ("\"a\\\"b\\\\c/\\b\\f\\n\\r\\t\\u0001\\u001f\xc3\xa9\"", json);
+	
+	// escapes at every position of the 8-byte words
+	for (std::size_t pos = 0 ; pos < 20 ; ++pos)
+	{
+		std::string str(20, 'x');
+		str[pos] = '"';
+		
+		json.clear();
+		w.String(str.data(), str.size());
+		ASSERT_EQ("\"" + str.substr(0, pos) + "\\\"" + str.substr(pos + 1) + "\"", json);
+	}
+}
+
+TEST(WriterTest, WriteJVar)
+{
+	JVar var;
+	var.Add("key \"1\"", 1LL).Add("list", JVar(std::vector<double>{1.5, 2}));
+	var["list"].Add(JVar(true)).Add(JVar()).Add(JVar("a\nb"));
+	
+	std::ostringstream os;
+	os << var;
+	ASSERT_EQ("{\"key \\\"1\\\"\":1,\"list\":[1.5,2.0,true,null,\"a\\nb\"]}", os.str());
+	
+	std::string json;
+	Writer(json).Value(JVar());
+	ASSERT_EQ("null", json);
+}
+
+TEST(WriterTest, RoundTrip)
+{
+	std::string json;
+	std::ifstream file(TEST_DATA "paddrive.json");
+	std::copy(
+		(std::istreambuf_iterator<char>(file)),
+		(std::istreambuf_iterator<char>()),
+		std::back_inserter(json));
+	
+	JVar var;
+	JVarBuilder h;
+	JsonParser sub(&h, 20);
+	sub.Parse(json.data(), json.size(), &var);
+	
+	std::string out1;
+	Writer(out1).Value(var);
+	
+	JVar copy;
+	JsonParser sub2(&h, 20);
+	sub2.Parse(out1.data(), out1.size(), &copy);
+	
+	std::string out2;
+	Writer(out2).Value(copy);
+	ASSERT_EQ(out1, out2);
+	ASSERT_EQ(var["items"][0]["title"].Str(), copy["items"][0]["title"].Str());
+}
+
+TEST(WriterTest, StreamTokens)
+{
+	std::string json;
+	StreamWriter w(json);
+	
+	w.StartObject();
+	w.Key("id", 2);
+	w.Int(7);
+	w.Key(StringView{json.data(), json.data()});
+	w.StartArray();
+	w.Null();
+	w.StartObject();
+	w.EndObject();
+	w.StartArray();
+	w.EndArray();
+	w.Real(0.5);
+	w.String("a\"", 2);
+	w.Value(JVar(std::vector<int>{1, 2}));
+	w.EndArray();
+	w.Key("ok", 2);
+	w.Bool(false);
+	w.EndObject();
+	
+	ASSERT_EQ("{\"id\":7,\"\":[null,{},[],0.5,\"a\\\"\",[1,2]],\"ok\":false}", json);
+}
+
+TEST(WriterTest, StreamChunksToSink)
+{
+	const std::size_t chunk_size = 16;
+	
+	std::vector<std::string> chunks;
+	StreamWriter w([&chunks](const char *data, std::size_t len)
+	{
+		chunks.emplace_back(data, len);
+	}, chunk_size);
+	
+	std::string expected = "[";
+	w.StartArray();
+	for (int i = 0 ; i < 1000 ; ++i)
+	{
+		w.StartObject();
+		w.Key("n", 1);
+		w.Int(i);
+		w.EndObject();
+		
+		expected += (i > 0 ? ",{\"n\":" : "{\"n\":") + std::to_string(i) + "}";
+	}
+	w.EndArray();
+	expected += "]";
+	
+	// only full chunks are passed before Flush()
+	ASSERT_EQ(expected.size() / chunk_size, chunks.size());
+	for (const auto& chunk : chunks)
+		ASSERT_EQ(chunk_size, chunk.size());
+	
+	// the last partial chunk
+	w.Flush();
+	ASSERT_GE(chunk_size, chunks.back().size());
+	
+	std::string all;
+	for (const auto& chunk : chunks)
+		all += chunk;
+	ASSERT_EQ(expected, all);
+}